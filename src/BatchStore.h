@@ -0,0 +1,61 @@
+// Batches of transactions relayed by trickle relay (relay = trickle) that are
+// on their way over a link.  A batch's relay event carries only its batch
+// number, and the receiver takes the batch out when the event runs.  With
+// more than one partition, batches are added and taken by different threads,
+// so the store is locked; a lock is taken once per batch, not per tx.
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include "Snapshot.h"
+
+#ifndef BATCHSTORE_H
+#define BATCHSTORE_H
+
+using namespace std;
+
+class BatchStore {
+    public:
+        unsigned int add(vector<unsigned int>& tx_nos) { // takes the tx numbers, leaving tx_nos empty
+            lock_guard<mutex> guard(_lock);
+            unsigned int batch_no;
+            if (_free.empty()) {
+                batch_no = _batches.size();
+                _batches.push_back(vector<unsigned int>());
+            } else {
+                batch_no = _free.back();
+                _free.pop_back();
+            }
+            _batches[batch_no].swap(tx_nos);
+            return batch_no;
+        }
+        void take(unsigned int batch_no, vector<unsigned int>& tx_nos) { // replaces tx_nos with the batch
+            lock_guard<mutex> guard(_lock);
+            tx_nos.swap(_batches[batch_no]);
+            _batches[batch_no].clear();
+            _free.push_back(batch_no);
+        }
+        unsigned int oldest_tx(unsigned int floor) { // the lowest of floor and the txs of the batches on their way
+            lock_guard<mutex> guard(_lock);
+            for (vector<vector<unsigned int> >::iterator it = _batches.begin(); it != _batches.end(); ++it) {
+                if (!it->empty()) floor = min(floor, *min_element(it->begin(), it->end()));
+            }
+            return floor;
+        }
+        void save(SnapshotWriter& out) const {
+            out.put((uint64_t)_batches.size());
+            for (vector<vector<unsigned int> >::const_iterator it = _batches.begin(); it != _batches.end(); ++it) out.put(*it);
+            out.put(_free);
+        }
+        void restore(SnapshotReader& in) {
+            _batches.resize(in.get_count(sizeof(uint64_t)));
+            for (vector<vector<unsigned int> >::iterator it = _batches.begin(); it != _batches.end(); ++it) in.get(*it);
+            in.get(_free);
+        }
+    private:
+        mutex _lock;
+        vector<vector<unsigned int> > _batches; // by batch number
+        vector<unsigned int> _free; // batch numbers that can be used again
+};
+
+#endif
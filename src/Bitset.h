@@ -0,0 +1,53 @@
+
+// A growable set of small non-negative integers, such as tx or block numbers,
+// stored one bit per number so membership tests are constant time.  For long
+// runs, the words below a number that will no longer be asked about can be
+// trimmed; the set then starts at that word, and numbers below it are taken
+// to be absent.
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "Snapshot.h"
+
+#ifndef BITSET_H
+#define BITSET_H
+
+class Bitset {
+    public:
+        Bitset() : _base(0) {}
+        bool test(unsigned int i) const {
+            size_t word = i >> 6;
+            return word >= _base && word - _base < _words.size() && ((_words[word - _base] >> (i & 63)) & 1);
+        }
+        void set(unsigned int i) {
+            size_t word = i >> 6;
+            if (word < _base) return; // trimmed
+            word -= _base;
+            if (word >= _words.size()) _words.resize(std::max(word + 1, 2 * _words.size()), 0);
+            _words[word] |= (uint64_t)1 << (i & 63);
+        }
+        void reset(unsigned int i) {
+            size_t word = i >> 6;
+            if (word >= _base && word - _base < _words.size()) _words[word - _base] &= ~((uint64_t)1 << (i & 63));
+        }
+        void trim(unsigned int floor) { // forget the numbers below floor (rounded down to a word)
+            size_t base = floor >> 6;
+            if (base <= _base) return;
+            _words.erase(_words.begin(), _words.begin() + std::min(base - _base, _words.size()));
+            _base = base;
+        }
+        void save(SnapshotWriter& out) const {
+            out.put((uint64_t)_base);
+            out.put(_words);
+        }
+        void restore(SnapshotReader& in) {
+            _base = in.get<uint64_t>();
+            in.get(_words);
+        }
+    private:
+        size_t _base; // the word _words starts at
+        std::vector<uint64_t> _words;
+};
+
+#endif
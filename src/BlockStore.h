@@ -0,0 +1,71 @@
+
+// Every block mined during a run, shared by all nodes.  Blocks never change
+// once mined, so nodes and relay events refer to them by block number instead
+// of each holding a copy of the block's transactions.  For long runs, the
+// bodies of old blocks that have reached every node can be pruned, leaving
+// only their headers.
+
+#include <algorithm>
+#include <vector>
+#include "Node.h"
+
+#ifndef BLOCKSTORE_H
+#define BLOCKSTORE_H
+
+using namespace std;
+
+class BlockStore {
+    public:
+        BlockStore() : _unpruned(0) {}
+        ~BlockStore() {
+            for (vector<Block*>::iterator it = _blocks.begin(); it != _blocks.end(); ++it) {
+                if (*it == NULL) continue;
+                (*it)->prune();
+                delete *it;
+            }
+        }
+        void add(Block* b) { // takes ownership of the block and its transactions
+            if (b->get_block_no() >= _blocks.size()) _blocks.resize(b->get_block_no() + 1, NULL);
+            _blocks[b->get_block_no()] = b;
+        }
+        Block* get(unsigned int block_no) { return _blocks.at(block_no); }
+        size_t size() const { return _blocks.size(); }
+        void prune(unsigned int keep, int num_nodes) { // free the bodies of blocks older than the latest keep that every node has
+            // bodies are freed oldest first, so a block that is slow to spread holds back the ones after it
+            while (_unpruned + keep < _blocks.size()) {
+                Block* b = _blocks[_unpruned];
+                if (b != NULL) {
+                    if (b->get_receivers() < num_nodes) break;
+                    b->prune();
+                }
+                ++_unpruned;
+            }
+        }
+        unsigned int oldest_tx(unsigned int floor) const { // the lowest of floor and the txs of the bodies not yet pruned
+            for (size_t i = _unpruned; i < _blocks.size(); ++i) {
+                vector<unsigned int>* txs = _blocks[i] != NULL ? _blocks[i]->get_transactions() : NULL;
+                if (txs != NULL && !txs->empty()) floor = min(floor, *min_element(txs->begin(), txs->end()));
+            }
+            return floor;
+        }
+        void save(SnapshotWriter& out) const {
+            out.put((uint64_t)_blocks.size());
+            for (vector<Block*>::const_iterator it = _blocks.begin(); it != _blocks.end(); ++it) {
+                out.put(*it != NULL);
+                if (*it != NULL) (*it)->save(out);
+            }
+            out.put((uint64_t)_unpruned);
+        }
+        void restore(SnapshotReader& in) { // into an empty store
+            _blocks.resize(in.get_count(sizeof(bool)), NULL);
+            for (vector<Block*>::iterator it = _blocks.begin(); it != _blocks.end(); ++it) {
+                if (in.get<bool>()) *it = new Block(in);
+            }
+            _unpruned = in.get<uint64_t>();
+        }
+    private:
+        vector<Block*> _blocks; // indexed by block number
+        size_t _unpruned; // blocks before this one have been pruned
+};
+
+#endif
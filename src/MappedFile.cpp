@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "MappedFile.h"
+
+MappedFile::~MappedFile() {
+    if (this->_data != NULL) munmap((void*)this->_data, this->_size);
+}
+
+bool MappedFile::map(const char* path, const char* kind) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        fprintf(stderr, "Cannot open %s file '%s'\n", kind, path);
+        return false;
+    }
+    size_t size = st.st_size;
+    void* data = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd); // the mapping stays
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Cannot map %s file '%s'\n", kind, path);
+        return false;
+    }
+    this->_data = (const char*)data;
+    this->_size = size;
+    return true;
+}
+
+bool MappedFile::check_header(const char* data, size_t size, const char* magic, uint32_t version,
+                              const char* kind, const char* path) {
+    if (size < FILE_HEADER_SIZE || memcmp(data, magic, FILE_MAGIC_SIZE) != 0) {
+        fprintf(stderr, "'%s' is not a %s file\n", path, kind);
+        return false;
+    }
+    uint32_t file_version, byte_order_mark;
+    memcpy(&file_version, data + FILE_MAGIC_SIZE, sizeof(file_version));
+    memcpy(&byte_order_mark, data + FILE_MAGIC_SIZE + sizeof(file_version), sizeof(byte_order_mark));
+    if (file_version != version || byte_order_mark != FILE_BYTE_ORDER_MARK) {
+        fprintf(stderr, "The %s file '%s' has version %u or byte order that this program cannot read\n", kind, path,
+                file_version);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+// A file mapped read-only into memory, for the binary files this program
+// writes (snapshots and traces).  Each of them starts with an 8-byte magic
+// string, a 32-bit format version and a byte order mark, so a file of
+// another kind, version or byte order is refused before it is read.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#define FILE_MAGIC_SIZE 8
+#define FILE_BYTE_ORDER_MARK 0x01020304 // written in the byte order of the machine
+#define FILE_HEADER_SIZE (FILE_MAGIC_SIZE + 4 + 4) // magic, version and byte order mark
+
+class MappedFile {
+    public:
+        MappedFile() : _data(NULL), _size(0) {}
+        ~MappedFile();
+        bool map(const char* path, const char* kind); // reporting errors about the kind of file to stderr
+        const char* data() const { return _data; }
+        size_t size() const { return _size; }
+        // whether data starts with magic, version and our byte order mark, reporting errors to stderr
+        static bool check_header(const char* data, size_t size, const char* magic, uint32_t version,
+                                 const char* kind, const char* path);
+    private:
+        MappedFile(const MappedFile&); // not copied
+        const char* _data;
+        size_t _size;
+};
+
+#endif
@@ -0,0 +1,59 @@
+
+#include <math.h>
+#include "Mempool.h"
+
+vector<unsigned int>* Mempool::top(size_t k) const {
+    // copy out the k highest-fee transactions, best first
+    vector<unsigned int>* tx_list = new vector<unsigned int>;
+    tx_list->reserve(min(k, this->_transactions.size()));
+    for (iterator it = this->begin(); it != this->end() && tx_list->size() < k; ++it) {
+        tx_list->push_back(*it);
+    }
+    return tx_list;
+}
+
+size_t Mempool::evict(const vector<unsigned int>& tx_nos, vector<unsigned int>* evicted_tx_nos) {
+    // remove the given transactions (e.g. those confirmed by a block), returning how many were present
+    // and, if evicted_tx_nos is given, appending them to it
+    size_t evicted = 0;
+    if (tx_nos.size() * log2(this->_transactions.size() + 1) < this->_transactions.size()) {
+        // a few transactions: look each one up
+        for (vector<unsigned int>::const_iterator it = tx_nos.begin(); it != tx_nos.end(); ++it) {
+            if (this->_transactions.erase(*it) == 0) continue;
+            ++evicted;
+            if (evicted_tx_nos != NULL) evicted_tx_nos->push_back(*it);
+        }
+        return evicted;
+    }
+
+    // many transactions: sort them into pool order and sweep the pool once
+    FeeOrder before = this->_transactions.key_comp();
+    vector<unsigned int> sorted(tx_nos);
+    sort(sorted.begin(), sorted.end(), before);
+    set<unsigned int, FeeOrder>::iterator it = this->_transactions.begin();
+    vector<unsigned int>::iterator confirmed = sorted.begin();
+    while (it != this->_transactions.end() && confirmed != sorted.end()) {
+        if (before(*it, *confirmed)) {
+            ++it;
+        } else if (before(*confirmed, *it)) {
+            ++confirmed;
+        } else {
+            if (evicted_tx_nos != NULL) evicted_tx_nos->push_back(*it);
+            it = this->_transactions.erase(it);
+            ++confirmed;
+            ++evicted;
+        }
+    }
+    return evicted;
+}
+
+void Mempool::save(SnapshotWriter& out) const {
+    out.put((uint64_t)this->_transactions.size());
+    for (iterator it = this->begin(); it != this->end(); ++it) out.put(*it);
+}
+
+void Mempool::restore(SnapshotReader& in) {
+    // the txs were saved in fee order, so each one goes at the end
+    size_t size = in.get_count(sizeof(unsigned int));
+    for (size_t i = 0; i < size; ++i) this->_transactions.insert(this->_transactions.end(), in.get<unsigned int>());
+}
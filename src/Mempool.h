@@ -0,0 +1,50 @@
+
+// A node's pool of unconfirmed transactions, kept ordered by fee so a miner
+// can pick the best-paying transactions without sorting the whole pool.
+
+#include <set>
+#include <vector>
+#include <algorithm>
+#include "TxTable.h"
+#include "Snapshot.h"
+
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+using namespace std;
+
+// orders tx numbers by decreasing fee, then by increasing tx number
+struct FeeOrder {
+    FeeOrder(const TxTable* tx_table) : tx_table(tx_table) {}
+    bool operator()(unsigned int tx1, unsigned int tx2) const {
+        float fee1 = tx_table->get_tx_fee(tx1), fee2 = tx_table->get_tx_fee(tx2);
+        if (fee1 != fee2) return fee1 > fee2;
+        return tx1 < tx2;
+    }
+    const TxTable* tx_table;
+};
+
+class Mempool {
+    public:
+        typedef set<unsigned int, FeeOrder>::const_iterator iterator;
+        Mempool(const TxTable* tx_table) : _transactions(FeeOrder(tx_table)) {}
+        bool insert(unsigned int tx_no) { return _transactions.insert(tx_no).second; }
+        bool erase(unsigned int tx_no) { return _transactions.erase(tx_no) > 0; }
+        unsigned int drop_lowest() { // remove the lowest-fee tx, returning its number; the pool must not be empty
+            iterator lowest = prev(_transactions.end());
+            unsigned int tx_no = *lowest;
+            _transactions.erase(lowest);
+            return tx_no;
+        }
+        size_t size() const { return _transactions.size(); }
+        iterator begin() const { return _transactions.begin(); } // highest fee first
+        iterator end() const { return _transactions.end(); }
+        vector<unsigned int>* top(size_t k) const;
+        size_t evict(const vector<unsigned int>& tx_nos, vector<unsigned int>* evicted_tx_nos = NULL);
+        void save(SnapshotWriter& out) const;
+        void restore(SnapshotReader& in); // into an empty pool
+    private:
+        set<unsigned int, FeeOrder> _transactions;
+};
+
+#endif
@@ -0,0 +1,49 @@
+
+// A lock-free queue with many producers and one consumer.  Producers push
+// onto an atomic linked stack; the consumer takes the whole stack at once and
+// reverses it, so every producer's items come out in the order it pushed them.
+
+#include <atomic>
+#include <vector>
+
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+template <typename T>
+class MpscQueue {
+    public:
+        MpscQueue() : _head(nullptr) {}
+        ~MpscQueue() { std::vector<T> rest; take(rest); }
+        bool empty() const { return _head.load(std::memory_order_acquire) == nullptr; }
+        void push(const T& value) { // safe to call from any thread
+            Item* item = new Item;
+            item->value = value;
+            item->next = _head.load(std::memory_order_relaxed);
+            while (!_head.compare_exchange_weak(item->next, item, std::memory_order_release,
+                                                std::memory_order_relaxed)) {}
+        }
+        void take(std::vector<T>& out) { // append every pushed item to out, oldest first; consumer only
+            Item* item = _head.exchange(nullptr, std::memory_order_acquire);
+            Item* oldest = nullptr;
+            while (item != nullptr) {
+                Item* next = item->next;
+                item->next = oldest;
+                oldest = item;
+                item = next;
+            }
+            while (oldest != nullptr) {
+                Item* next = oldest->next;
+                out.push_back(oldest->value);
+                delete oldest;
+                oldest = next;
+            }
+        }
+    private:
+        struct Item {
+            T value;
+            Item* next;
+        };
+        std::atomic<Item*> _head;
+};
+
+#endif
@@ -0,0 +1,80 @@
+
+#include "Network.h"
+#include "Node.h"
+
+Network::Network(unsigned int num_nodes)
+    : _nodes(num_nodes, NULL), _types(num_nodes, RELAY), _greediness(num_nodes, 0), _building(num_nodes) {
+}
+
+Network::~Network() {
+    for (vector<Node*>::iterator it = this->_nodes.begin(); it != this->_nodes.end(); ++it) {
+        delete *it;
+    }
+}
+
+void Network::add_link(unsigned int node1, unsigned int node2, float speed) {
+    this->_building[node1].push_back(make_pair(node2, speed));
+    this->_building[node2].push_back(make_pair(node1, speed));
+}
+
+bool Network::linked(unsigned int node1, unsigned int node2) const {
+    // look through the shorter list of links
+    if (this->get_num_links(node2) < this->get_num_links(node1)) swap(node1, node2);
+    if (this->_offsets.empty()) {
+        const vector<pair<unsigned int, float> >& links = this->_building[node1];
+        for (size_t i = 0; i < links.size(); ++i) {
+            if (links[i].first == node2) return true;
+        }
+        return false;
+    }
+    for (unsigned int link = this->links_begin(node1); link != this->links_end(node1); ++link) {
+        if (this->_neighbors[link] == node2) return true;
+    }
+    return false;
+}
+
+unsigned int Network::get_num_links(unsigned int node_no) const {
+    if (this->_offsets.empty()) return this->_building[node_no].size();
+    return this->_offsets[node_no + 1] - this->_offsets[node_no];
+}
+
+void Network::pack() {
+    // every node's links keep the order they were added in
+    unsigned int num_nodes = this->size();
+    this->_offsets.resize(num_nodes + 1);
+    this->_offsets[0] = 0;
+    for (unsigned int i = 0; i < num_nodes; ++i) {
+        this->_offsets[i + 1] = this->_offsets[i] + this->_building[i].size();
+    }
+    this->_neighbors.reserve(this->_offsets[num_nodes]);
+    this->_speeds.reserve(this->_offsets[num_nodes]);
+    for (unsigned int i = 0; i < num_nodes; ++i) {
+        for (size_t j = 0; j < this->_building[i].size(); ++j) {
+            this->_neighbors.push_back(this->_building[i][j].first);
+            this->_speeds.push_back(this->_building[i][j].second);
+        }
+    }
+    vector<vector<pair<unsigned int, float> > >().swap(this->_building);
+}
+
+void Network::save(SnapshotWriter& out) const {
+    out.put(this->_types);
+    out.put(this->_greediness);
+    out.put(this->_offsets);
+    out.put(this->_neighbors);
+    out.put(this->_speeds);
+}
+
+void Network::restore(SnapshotReader& in) {
+    unsigned int num_nodes = this->size();
+    in.get(this->_types);
+    in.get(this->_greediness);
+    in.get(this->_offsets);
+    in.get(this->_neighbors);
+    in.get(this->_speeds);
+    vector<vector<pair<unsigned int, float> > >().swap(this->_building);
+    if (this->_types.size() != num_nodes || this->_greediness.size() != num_nodes || this->_offsets.size() != num_nodes + 1
+        || this->_neighbors.size() != this->_offsets[num_nodes] || this->_speeds.size() != this->_neighbors.size()) {
+        in.fail();
+    }
+}
@@ -0,0 +1,59 @@
+
+// The nodes of the network and its topology.  The fields that the relay and
+// mining loops read for every node (type, greediness and links) are kept in
+// arrays indexed by node number rather than in the nodes themselves.  Links
+// are added while the network is built; pack() then lays them out as a
+// compressed sparse row (CSR) graph, so a node's links are one contiguous run
+// of neighbor numbers and latencies: links_begin(n) to links_end(n).
+
+#include <utility>
+#include <vector>
+#include "Snapshot.h"
+
+#ifndef NETWORK_H
+#define NETWORK_H
+
+using namespace std;
+
+class Node;
+
+enum Type { RELAY, MINER };
+
+class Network {
+    public:
+        Network(unsigned int num_nodes);
+        ~Network(); // deletes the nodes
+        unsigned int size() const { return _types.size(); }
+        Node* node(unsigned int node_no) const { return _nodes[node_no]; }
+        void set_node(unsigned int node_no, Node* node) { _nodes[node_no] = node; }
+        Type get_type(unsigned int node_no) const { return (Type)_types[node_no]; }
+        void set_type(unsigned int node_no, Type type) { _types[node_no] = type; }
+        int get_greediness(unsigned int node_no) const { return _greediness[node_no]; }
+        void set_greediness(unsigned int node_no, int greediness) { _greediness[node_no] = greediness; }
+
+        // building
+        void add_link(unsigned int node1, unsigned int node2, float speed); // add a link both ways
+        bool linked(unsigned int node1, unsigned int node2) const;
+        unsigned int get_num_links(unsigned int node_no) const;
+        void pack(); // lay the links out in CSR form; no links can be added afterwards
+
+        // links of a packed network
+        unsigned int links_begin(unsigned int node_no) const { return _offsets[node_no]; }
+        unsigned int links_end(unsigned int node_no) const { return _offsets[node_no + 1]; }
+        unsigned int neighbor(unsigned int link) const { return _neighbors[link]; }
+        float speed(unsigned int link) const { return _speeds[link]; }
+
+        // types, greediness and links of a packed network; the nodes are saved separately
+        void save(SnapshotWriter& out) const;
+        void restore(SnapshotReader& in); // into a new network of the same size
+    private:
+        vector<Node*> _nodes;
+        vector<unsigned char> _types;
+        vector<int> _greediness;
+        vector<vector<pair<unsigned int, float> > > _building; // links by node, until pack()
+        vector<unsigned int> _offsets; // node n's links are _offsets[n] to _offsets[n + 1]
+        vector<unsigned int> _neighbors;
+        vector<float> _speeds;
+};
+
+#endif
@@ -1,174 +1,410 @@
 
 #include <algorithm>
+#include <chrono>
 #include "Node.h"
+#include "Mempool.h"
+#include "Partition.h"
+#include "BatchStore.h"
+#include "BlockStore.h"
+#include "Stats.h"
+#include "Tracer.h"
 #include "simlib.h"
 #include "blockchain-sim-defs.h"
 
-Node::Node(Type type, unsigned int node_no) {
-    this->_type = type;
+Block::Block(unsigned int block_no, vector<unsigned int>* transactions, double block_time, float block_reward,
+             const TxTable* tx_table) {
+    this->_block_no = block_no;
+    this->_transactions = transactions;
+    this->_block_time = block_time;
+    this->_block_reward = block_reward;
+    this->_num_transactions = transactions->size();
+    this->_receivers = 0;
+
+    // every tx in the block was confirmed at the block's time
+    double total_time_to_confirmation = 0;
+    float total_tx_fees = 0;
+    for (vector<unsigned int>::iterator it = transactions->begin(); it != transactions->end(); ++it) {
+        total_time_to_confirmation += (block_time - tx_table->get_broadcast_time(*it));
+        total_tx_fees += tx_table->get_tx_fee(*it);
+    }
+    this->_avg_ttc = this->_num_transactions > 0 ? total_time_to_confirmation / this->_num_transactions : 0;
+    this->_avg_tx_fee = this->_num_transactions > 0 ? total_tx_fees / this->_num_transactions : 0;
+}
+
+Block::Block(SnapshotReader& in) {
+    this->_block_no = in.get<unsigned int>();
+    this->_block_time = in.get<double>();
+    this->_block_reward = in.get<float>();
+    this->_num_transactions = in.get<unsigned int>();
+    this->_avg_ttc = in.get<double>();
+    this->_avg_tx_fee = in.get<float>();
+    this->_receivers = in.get<int>();
+    this->_transactions = NULL;
+    if (in.get<bool>()) {
+        this->_transactions = new vector<unsigned int>;
+        in.get(*this->_transactions);
+    }
+}
+
+void Block::save(SnapshotWriter& out) {
+    out.put(this->_block_no);
+    out.put(this->_block_time);
+    out.put(this->_block_reward);
+    out.put(this->_num_transactions);
+    out.put(this->_avg_ttc);
+    out.put(this->_avg_tx_fee);
+    out.put((int)this->_receivers);
+    out.put(this->_transactions != NULL); // the body, unless it was pruned
+    if (this->_transactions != NULL) out.put(*this->_transactions);
+}
+
+Node::Node(unsigned int node_no, const Network* network, TxTable* tx_table, BlockStore* block_store, BatchStore* batches,
+           RunStats* stats, Partition* partition, const Parameters* params) {
     this->_node_no = node_no;
-    this->_adj_list = new vector<Link*>;
-    this->_known_transactions = new vector<Transaction>;
-    this->_known_blocks = new vector<Block*>;
-    this->_in_transit_tx_nos = new vector<unsigned int>;
-    this->_in_transit_block_nos = new vector<unsigned int>;
+    this->_network = network;
+    this->_tx_table = tx_table;
+    this->_block_store = block_store;
+    this->_batches = batches;
+    this->_stats = stats;
+    this->_partition = partition;
+    this->_params = params;
+    this->_known_transactions = new Mempool(tx_table);
 }
 
 Node::~Node() {
-    for (vector<Link*>::iterator it = this->_adj_list->begin(); it != this->_adj_list->end(); ++it) {
-        delete *it;
-    }
-    delete this->_adj_list;
     delete this->_known_transactions;
-    for (vector<Block*>::iterator it = this->_known_blocks->begin(); it != this->_known_blocks->end(); ++it) {
-        delete (*it)->get_transactions();
-        delete *it;
-    }
-    delete this->_known_blocks;
-    delete this->_in_transit_tx_nos;
-    delete this->_in_transit_block_nos;
 }
 
-void Node::add_link(Node* other_node, float speed) {
-    Link* new_link = new Link(other_node, speed);
-    this->_adj_list->push_back(new_link);
+bool Node::aware_of_tx(unsigned int tx_no) {
+    return this->_known_tx_nos.test(tx_no) || this->_in_transit_tx_nos.test(tx_no);
 }
 
-bool Node::aware_of(Transaction tx) {
-    bool already_known = false;
-    for (vector<Transaction>::iterator it = this->_known_transactions->begin(); it != this->_known_transactions->end(); ++it) {
-        if (it->get_tx_no() == tx.get_tx_no()) already_known = true;
-    }
-    for (vector<unsigned int>::iterator it = this->_in_transit_tx_nos->begin(); it != this->_in_transit_tx_nos->end(); ++it) {
-        if (*it == tx.get_tx_no()) already_known = true;
+bool Node::aware_of(Block* b) {
+    return this->_known_block_nos.test(b->get_block_no()) || this->_in_transit_block_nos.test(b->get_block_no());
+}
+
+void Node::in_transit_tx(unsigned int tx_no) {
+    this->mark(UNDO_IN_TRANSIT_TX, tx_no, true);
+}
+
+void Node::in_transit_block(unsigned int block_no) {
+    this->mark(UNDO_IN_TRANSIT_BLOCK, block_no, true);
+}
+
+Bitset& Node::bits(int kind) {
+    switch (kind) {
+        case UNDO_SEEN_TX: return this->_seen_tx_nos;
+        case UNDO_KNOWN_TX: return this->_known_tx_nos;
+        case UNDO_KNOWN_BLOCK: return this->_known_block_nos;
+        case UNDO_IN_TRANSIT_TX: return this->_in_transit_tx_nos;
+        default: return this->_in_transit_block_nos;
     }
-    return already_known;
 }
 
-bool Node::aware_of(Block* b) {
-    bool already_known = false;
-    for (vector<Block*>::iterator it = this->_known_blocks->begin(); it != this->_known_blocks->end(); ++it) {
-        if ((*it)->get_block_no() == b->get_block_no()) already_known = true;
+void Node::mark(int kind, unsigned int no, bool value) {
+    Bitset& bits = this->bits(kind);
+    if (bits.test(no) == value) return;
+    if (value) bits.set(no);
+    else bits.reset(no);
+    this->_partition->save(this, kind, no);
+}
+
+void Node::undo(int kind, unsigned int no) {
+    switch (kind) {
+        case UNDO_MEMPOOL_INSERT:
+            this->_known_transactions->erase(no);
+            --this->_partition->mempool_txs;
+            break;
+        case UNDO_MEMPOOL_ERASE:
+            this->_known_transactions->insert(no);
+            ++this->_partition->mempool_txs;
+            break;
+        case UNDO_MEMPOOL_DROP:
+            this->_known_transactions->insert(no);
+            ++this->_partition->mempool_txs;
+            --this->_partition->mempool_drops;
+            break;
+        case UNDO_BLOCK_PUSH:
+            this->_known_blocks.back()->received(-1);
+            this->_known_blocks.pop_back();
+            break;
+        case UNDO_BLOCK_DROP:
+            this->_known_blocks.push_front(this->_block_store->get(no));
+            break;
+        default: {
+            Bitset& bits = this->bits(kind);
+            if (bits.test(no)) bits.reset(no);
+            else bits.set(no);
+        }
     }
-    for (vector<unsigned int>::iterator it = this->_in_transit_block_nos->begin(); it != this->_in_transit_block_nos->end(); ++it) {
-        if (*it == b->get_block_no()) already_known = true;
+}
+
+unsigned int Node::oldest_relayed_tx(unsigned int floor) const {
+    for (vector<Trickled>::const_iterator it = this->_trickle.begin(); it != this->_trickle.end(); ++it) {
+        floor = min(floor, it->tx_no);
     }
-    return already_known;
+    return floor;
 }
 
-bool Node::linked_to(unsigned int node_no) {
-    bool linked = false;
-    for (vector<Link*>::iterator it = this->_adj_list->begin(); it != this->_adj_list->end(); ++it) {
-        if ((*it)->get_other_node()->get_node_no() == node_no) linked = true;
+unsigned int Node::oldest_pooled_tx(unsigned int floor) const {
+    for (Mempool::iterator it = this->_known_transactions->begin(); it != this->_known_transactions->end(); ++it) {
+        floor = min(floor, *it);
     }
-    return linked;
+    return floor;
 }
 
-void Node::in_transit_tx(unsigned int tx_no) {
-    this->_in_transit_tx_nos->push_back(tx_no);
+void Node::trim(unsigned int tx_floor, unsigned int block_floor) {
+    this->_known_tx_nos.trim(tx_floor);
+    this->_in_transit_tx_nos.trim(tx_floor);
+    this->_seen_tx_nos.trim(tx_floor);
+    this->_known_block_nos.trim(block_floor);
+    this->_in_transit_block_nos.trim(block_floor);
 }
 
-void Node::in_transit_block(unsigned int block_no) {
-    this->_in_transit_block_nos->push_back(block_no);
+void Node::save(SnapshotWriter& out) const {
+    this->_known_transactions->save(out);
+    out.put((uint64_t)this->_known_blocks.size());
+    for (deque<Block*>::const_iterator it = this->_known_blocks.begin(); it != this->_known_blocks.end(); ++it) {
+        out.put((*it)->get_block_no());
+    }
+    this->_known_tx_nos.save(out);
+    this->_known_block_nos.save(out);
+    this->_in_transit_tx_nos.save(out);
+    this->_in_transit_block_nos.save(out);
+    this->_seen_tx_nos.save(out);
+    out.put(this->_trickle);
+}
+
+void Node::restore(SnapshotReader& in) {
+    this->_known_transactions->restore(in);
+    size_t num_blocks = in.get_count(sizeof(unsigned int));
+    for (size_t i = 0; i < num_blocks; ++i) {
+        unsigned int block_no = in.get<unsigned int>();
+        if (block_no >= this->_block_store->size() || this->_block_store->get(block_no) == NULL) {
+            in.fail();
+            return;
+        }
+        this->_known_blocks.push_back(this->_block_store->get(block_no));
+    }
+    this->_known_tx_nos.restore(in);
+    this->_known_block_nos.restore(in);
+    this->_in_transit_tx_nos.restore(in);
+    this->_in_transit_block_nos.restore(in);
+    this->_seen_tx_nos.restore(in);
+    in.get(this->_trickle);
 }
 
-void Node::broadcast_transaction(Transaction tx) {
+bool Node::accept_transaction(unsigned int tx_no) {
+    if (this->_params->relay_policy != RELAY_PEEK) {
+        // drop copies of transactions we have already seen (or seen confirmed)
+        if (this->_seen_tx_nos.test(tx_no)) return false;
+        this->mark(UNDO_SEEN_TX, tx_no, true);
+    }
+
     // add it to our list of transactions
-    this->_known_transactions->push_back(tx);
+    if (this->_known_transactions->insert(tx_no)) {
+        ++this->_partition->mempool_txs;
+        this->_partition->save(this, UNDO_MEMPOOL_INSERT, tx_no);
+    }
+    if (this->_params->mempool_cap > 0 && this->_known_transactions->size() > (size_t)this->_params->mempool_cap) {
+        // a full mempool drops its lowest-fee tx, which we still count as known, so it is not relayed to us again
+        unsigned int dropped = this->_known_transactions->drop_lowest();
+        --this->_partition->mempool_txs;
+        ++this->_partition->mempool_drops;
+        this->_partition->save(this, UNDO_MEMPOOL_DROP, dropped);
+    }
+    this->mark(UNDO_KNOWN_TX, tx_no, true);
 
     // remove it from the list of in transit transactions
-    auto new_end = remove_if(this->_in_transit_tx_nos->begin(), this->_in_transit_tx_nos->end(),
-                             [&](unsigned int tx_no) { return tx_no == tx.get_tx_no(); });
-    this->_in_transit_tx_nos->erase(new_end, this->_in_transit_tx_nos->end());
+    this->mark(UNDO_IN_TRANSIT_TX, tx_no, false);
+    return true;
+}
+
+void Node::broadcast_transaction(unsigned int tx_no, int from_node) {
+    bool copy = false;
+    if (this->_partition->trace != NULL) {
+        // With relay = peek a copy is accepted too, and a block may have taken
+        // the tx out of our mempool before it came again, so while tracing we
+        // remember every tx that reached us (peek relay does not look at it).
+        copy = this->_seen_tx_nos.test(tx_no) || this->_known_tx_nos.test(tx_no);
+        if (this->_params->relay_policy == RELAY_PEEK) this->_seen_tx_nos.set(tx_no);
+    }
+    bool accepted = this->accept_transaction(tx_no);
+    if (this->_partition->trace != NULL) {
+        int kind = from_node < 0 ? TRACE_NEW_TX : copy ? TRACE_TX_COPY : TRACE_TX_ARRIVAL;
+        this->_partition->trace->put(kind, this->_partition->sl.sim_time, tx_no, from_node, this->_node_no);
+    }
+    if (!accepted) return;
+
+    if (this->_params->relay_policy == RELAY_TRICKLE) {
+        // gather it for our next batch, which is sent trickle_interval after its first tx
+        if (this->_trickle.empty()) this->post_flush();
+        this->_trickle.push_back(Trickled { tx_no, from_node, this->_partition->sl.sim_time });
+        return;
+    }
 
     // schedule events for neighboring nodes to be aware of it
-    for (vector<Link*>::iterator it = this->_adj_list->begin(); it != this->_adj_list->end(); ++it) {
-        if (!((*it)->get_other_node()->aware_of(tx))) {
+    const Network* network = this->_network;
+    for (unsigned int link = network->links_begin(this->_node_no); link != network->links_end(this->_node_no); ++link) {
+        unsigned int to_node = network->neighbor(link);
+        if (this->_params->relay_policy == RELAY_GOSSIP
+            ? (int)to_node != from_node
+            : !network->node(to_node)->aware_of_tx(tx_no)) {
             #ifdef DEBUG
-            printf("broadcasting tx %d from node %d to node %d\n",
-                   tx.get_tx_no(), this->get_node_no(), (*it)->get_other_node()->get_node_no());
+            printf("broadcasting tx %d from node %d to node %d\n", tx_no, this->get_node_no(), to_node);
             #endif
-            transfer[3] = tx.get_tx_no();
-            transfer[4] = tx.get_tx_fee();
-            transfer[5] = (*it)->get_other_node()->get_node_no();
-            transfer[6] = tx.get_broadcast_time();
-            event_schedule(sim_time + (*it)->get_speed(), EVENT_TX_RELAY);
+            struct event ev;
+            ev.time = this->_partition->sl.sim_time + network->speed(link);
+            ev.type = EVENT_TX_RELAY;
+            ev.id[0] = tx_no;
+            ev.id[1] = to_node;
+            ev.id[2] = this->get_node_no();
+            this->_partition->post(ev, to_node);
             // record that it's in transit so it isn't broadcast again before it arrives
-            (*it)->get_other_node()->in_transit_tx(tx.get_tx_no());
+            if (this->_params->relay_policy == RELAY_PEEK) network->node(to_node)->in_transit_tx(tx_no);
         }
     }
 }
 
-void Node::broadcast_block(Block* b) {
-    // add it to our list of blocks
-    this->_known_blocks->push_back(b);
+bool Node::accept_block(Block* b) {
+    if (this->_params->relay_policy != RELAY_PEEK) {
+        // drop copies of blocks we have already seen
+        if (this->_known_block_nos.test(b->get_block_no())) return false;
+        // a transaction that arrives after its block is not added back to the mempool
+        for (vector<unsigned int>::iterator it = b->get_transactions()->begin(); it != b->get_transactions()->end(); ++it) {
+            this->mark(UNDO_SEEN_TX, *it, true);
+        }
+    }
+
+    // add it to our list of blocks, forgetting the oldest if we keep only the latest few
+    this->_known_blocks.push_back(b);
+    b->received(1);
+    this->_partition->save(this, UNDO_BLOCK_PUSH, b->get_block_no());
+    if (this->_params->blocks_kept > 0 && this->_known_blocks.size() > (size_t)this->_params->blocks_kept) {
+        this->_partition->save(this, UNDO_BLOCK_DROP, this->_known_blocks.front()->get_block_no());
+        this->_known_blocks.pop_front();
+    }
+    this->mark(UNDO_KNOWN_BLOCK, b->get_block_no(), true);
 
     // remove it from the list of in transit blocks
-    auto new_end = remove_if(this->_in_transit_block_nos->begin(), this->_in_transit_block_nos->end(),
-                             [&](unsigned int block_no) { return block_no == b->get_block_no(); });
-    this->_in_transit_block_nos->erase(new_end, this->_in_transit_block_nos->end());
+    this->mark(UNDO_IN_TRANSIT_BLOCK, b->get_block_no(), false);
 
     // remove transactions from _known_transactions that were included in the block
     #ifdef DEBUG
     printf("number of known transactions before block propagation: %d\n", this->_known_transactions->size());
     #endif
-    for (vector<Transaction>::iterator it = b->get_transactions()->begin(); it != b->get_transactions()->end(); ++it) {
-        auto new_end = remove_if(this->_known_transactions->begin(), this->_known_transactions->end(),
-                                 [&](Transaction  t) { return t.get_tx_no() == it->get_tx_no(); });
-        this->_known_transactions->erase(new_end, this->_known_transactions->end());
+    // speculative work may yet be rolled back, so only evictions outside it are timed
+    chrono::steady_clock::time_point eviction_start;
+    if (!this->_partition->logging) eviction_start = chrono::steady_clock::now();
+    if (this->_partition->logging) {
+        // save which transactions were evicted, so a rollback can put them back
+        vector<unsigned int> evicted_tx_nos;
+        this->_partition->mempool_txs -= this->_known_transactions->evict(*b->get_transactions(), &evicted_tx_nos);
+        for (vector<unsigned int>::iterator it = evicted_tx_nos.begin(); it != evicted_tx_nos.end(); ++it) {
+            this->_partition->save(this, UNDO_MEMPOOL_ERASE, *it);
+        }
+    } else {
+        this->_partition->mempool_txs -= this->_known_transactions->evict(*b->get_transactions());
+    }
+    for (vector<unsigned int>::iterator it = b->get_transactions()->begin(); it != b->get_transactions()->end(); ++it) {
+        this->mark(UNDO_KNOWN_TX, *it, false);
+    }
+    if (!this->_partition->logging) {
+        chrono::duration<float, micro> eviction_time = chrono::steady_clock::now() - eviction_start;
+        sampst(&this->_partition->sl, eviction_time.count(), SAMPST_EVICTION_TIME);
     }
     #ifdef DEBUG
     printf("number of known transactions after block propagation: %d\n", this->_known_transactions->size());
     #endif
+    return true;
+}
+
+void Node::broadcast_block(Block* b, int from_node) {
+    bool copy = this->_partition->trace != NULL && this->_known_block_nos.test(b->get_block_no());
+    bool accepted = this->accept_block(b);
+    if (this->_partition->trace != NULL) {
+        int kind = from_node < 0 ? TRACE_NEW_BLOCK : copy ? TRACE_BLOCK_COPY : TRACE_BLOCK_ARRIVAL;
+        this->_partition->trace->put(kind, this->_partition->sl.sim_time, b->get_block_no(), from_node, this->_node_no);
+    }
+    if (!accepted) return;
 
     // schedule events for neighboring nodes to be aware of it
-    for (vector<Link*>::iterator it = this->_adj_list->begin(); it != this->_adj_list->end(); ++it) {
-        if (!((*it)->get_other_node()->aware_of(b))) {
+    const Network* network = this->_network;
+    for (unsigned int link = network->links_begin(this->_node_no); link != network->links_end(this->_node_no); ++link) {
+        unsigned int to_node = network->neighbor(link);
+        if (this->_params->relay_policy != RELAY_PEEK
+            ? (int)to_node != from_node
+            : !network->node(to_node)->aware_of(b)) {
             #ifdef DEBUG
-            printf("broadcasting block %d from node %d to node %d\n",
-                           b->get_block_no(), this->get_node_no(), (*it)->get_other_node()->get_node_no());
+            printf("broadcasting block %d from node %d to node %d\n", b->get_block_no(), this->get_node_no(), to_node);
             #endif
-            transfer[3] = b->get_block_no();
-            transfer[4] = this->get_node_no();
-            transfer[5] = (*it)->get_other_node()->get_node_no();
-            transfer[6] = b->get_block_time();
-            transfer[7] = b->get_block_reward();
-            event_schedule(sim_time + (2 * (*it)->get_speed()), EVENT_BLOCK_RELAY);
+            struct event ev;
+            ev.time = this->_partition->sl.sim_time + (2 * network->speed(link));
+            ev.type = EVENT_BLOCK_RELAY;
+            ev.id[0] = b->get_block_no();
+            ev.id[1] = this->get_node_no();
+            ev.id[2] = to_node;
+            this->_partition->post(ev, to_node);
             // record that it's in transit so it isn't broadcast again before it arrives
-            (*it)->get_other_node()->in_transit_block(b->get_block_no());
+            if (this->_params->relay_policy == RELAY_PEEK) network->node(to_node)->in_transit_block(b->get_block_no());
         }
     }
 }
 
-vector<Transaction>* Node::get_block_transactions(unsigned int block_no) {
-    for (vector<Block*>::iterator it = this->_known_blocks->begin(); it != this->_known_blocks->end(); ++it) {
-        if ((*it)->get_block_no() == block_no) return new vector<Transaction>(*(*it)->get_transactions());
+void Node::post_flush() {
+    struct event ev;
+    ev.time = this->_partition->sl.sim_time + this->_params->trickle_interval;
+    ev.type = EVENT_TX_FLUSH;
+    ev.id[0] = this->get_node_no();
+    this->_partition->post(ev, this->get_node_no());
+}
+
+void Node::flush_transactions() {
+    // Txs that reached us at this very time wait for the next batch.  Events
+    // at the same time may run in either order (it depends on the partitions),
+    // and this way a batch holds the same txs whichever ran first.
+    double now = this->_partition->sl.sim_time;
+    vector<Trickled>::iterator last = this->_trickle.begin();
+    while (last != this->_trickle.end() && last->time < now) ++last;
+
+    // every neighbor gets the gathered txs it did not send us, in one relay event
+    const Network* network = this->_network;
+    vector<unsigned int> batch;
+    for (unsigned int link = network->links_begin(this->_node_no); link != network->links_end(this->_node_no); ++link) {
+        unsigned int to_node = network->neighbor(link);
+        for (vector<Trickled>::iterator it = this->_trickle.begin(); it != last; ++it) {
+            if (it->from_node != (int)to_node) batch.push_back(it->tx_no);
+        }
+        if (batch.empty()) continue;
+        #ifdef DEBUG
+        printf("sending %d txs from node %d to node %d\n", (int)batch.size(), this->get_node_no(), to_node);
+        #endif
+        struct event ev;
+        ev.time = this->_partition->sl.sim_time + network->speed(link);
+        ev.type = EVENT_TX_BATCH;
+        ev.id[0] = this->_batches->add(batch);
+        ev.id[1] = to_node;
+        ev.id[2] = this->get_node_no();
+        this->_partition->post(ev, to_node);
     }
-    return NULL; // control should never reach here
+    this->_trickle.erase(this->_trickle.begin(), last);
+    if (!this->_trickle.empty()) this->post_flush();
 }
 
-float Node::decide_tx_fee() {
+float Node::decide_tx_fee(Block* last_block) {
     // get the avg time to confirmation over the course of the simulation
-    sampst(0.0, -SAMPST_TTC);
-    float overall_avg_ttc = transfer[1];
+    double overall_avg_ttc = this->_stats->ttc.moments.mean();
 
     // calculate avg time to confirmation and avg fee in the most recent block
-    float avg_confirmation_time = 0;
-    float avg_tx_fee = DEFAULT_FEE;
-    if (this->_known_blocks->size() > 0) {
-        float total_time_to_confirmation = 0;
-        float total_tx_fees = 0;
-        Block* b = this->_known_blocks->back();
-        if (b->get_transactions()->size() == 0) {
+    double avg_confirmation_time = 0;
+    float avg_tx_fee = this->_params->default_fee;
+    if (last_block != NULL) {
+        if (last_block->get_num_transactions() == 0) {
             // if no transactions were confirmed, that's like an infinite time-to-confirmation
             avg_confirmation_time = overall_avg_ttc * 10;
         } else {
-            for (vector<Transaction>::iterator it = b->get_transactions()->begin(); it != b->get_transactions()->end(); ++it) {
-                total_time_to_confirmation += (it->get_confirmation_time() - it->get_broadcast_time());
-                total_tx_fees += it->get_tx_fee();
-            }
-            avg_confirmation_time = total_time_to_confirmation / b->get_transactions()->size();
-            avg_tx_fee = total_tx_fees / b->get_transactions()->size();
+            avg_confirmation_time = last_block->get_avg_ttc();
+            avg_tx_fee = last_block->get_avg_tx_fee();
         }
     }
     #ifdef DEBUG
@@ -180,42 +416,36 @@ float Node::decide_tx_fee() {
     // the fee should be proportional to the amount of network congestion
     float tx_fee;
     if (overall_avg_ttc == 0 || avg_confirmation_time == 0) {
-        tx_fee = DEFAULT_FEE;
+        tx_fee = this->_params->default_fee;
     } else {
         tx_fee = avg_tx_fee * (avg_confirmation_time / overall_avg_ttc);
     }
-    sampst(tx_fee, SAMPST_TX_FEE);
+    this->_stats->tx_fee.add(tx_fee);
     return tx_fee;
 }
 
-vector<Transaction>* Node::decide_included_tx_list(float block_reward, float block_time) {
+vector<unsigned int>* Node::decide_included_tx_list(float block_reward, double block_time) {
     // decide which transactions to include based on fees and block reward and greediness
+    int greediness = this->get_greediness();
 
-    if (this->_greediness == 0 || this->_known_transactions->size() == 0) {
+    if (greediness == 0 || this->_known_transactions->size() == 0) {
         #ifdef DEBUG
         printf("Included 0 transactions\n");
         #endif
-        return new vector<Transaction>;
+        return new vector<unsigned int>;
     }
 
-    // sort transactions by fee
-    sort(this->_known_transactions->begin(), this->_known_transactions->end(),
-         [](Transaction t1, Transaction t2) { return t1.get_tx_fee() < t2.get_tx_fee(); });
-
     // we should be greedier with tx fees if the block reward is low
-    float reward_factor = 1 - (block_reward / DEFAULT_BLOCK_REWARD);
-    float greediness_delta = (100 - this->_greediness) * reward_factor;
-    float real_greediness = this->_greediness + greediness_delta;
+    float reward_factor = 1 - (block_reward / this->_params->default_block_reward);
+    float greediness_delta = (100 - greediness) * reward_factor;
+    float real_greediness = greediness + greediness_delta;
 
     // include high-fee transactions based on greediness
     int last_tx_index = (int)(((float)real_greediness / 100.0) * this->_known_transactions->size());
-    vector<Transaction>* tx_list = new vector<Transaction>;
-    for (int i = 0; i < last_tx_index; ++i) {
-        Transaction t = this->_known_transactions->at(i);
-        t.set_confirmation_time(block_time);
-        float time_to_conf = block_time - t.get_broadcast_time();
-        sampst(time_to_conf, SAMPST_TTC);
-        tx_list->push_back(t);
+    vector<unsigned int>* tx_list = this->_known_transactions->top(last_tx_index);
+    for (vector<unsigned int>::iterator it = tx_list->begin(); it != tx_list->end(); ++it) {
+        double time_to_conf = block_time - this->_tx_table->get_broadcast_time(*it);
+        this->_stats->ttc.add(time_to_conf);
     }
     #ifdef DEBUG
     printf("Included %d transactions of %d\n", tx_list->size(), this->_known_transactions->size());
@@ -2,97 +2,120 @@
 // This class represents a server running blockchain software 
 // that relays transactions or mines blocks.
 
+#include <atomic>
+#include <deque>
 #include <iostream>
 #include <vector>
+#include "Bitset.h"
+#include "Snapshot.h"
+#include "Network.h"
+#include "TxTable.h"
+#include "Parameters.h"
+
+#ifndef NODE_H
+#define NODE_H
 
 using namespace std;
 
 class Node;
+class Mempool;
+class Partition;
+class BatchStore;
+class BlockStore;
+struct RunStats;
 
-enum Type { RELAY, MINER };
-
-typedef struct Link {
-    public:
-        Link(Node* other_node, float speed) {
-            _other_node = other_node;
-            _speed = speed;
-        }
-        Node* get_other_node() { return _other_node; }
-        float get_speed() { return _speed; }
-    private:
-        Node* _other_node;
-        float _speed;
-} Link;
-
-typedef struct Transaction {
-    public:
-        Transaction(unsigned int tx_no, float tx_fee, float broadcast_time) {
-            _tx_no = tx_no;
-            _tx_fee = tx_fee;
-            _broadcast_time = broadcast_time;
-        }
-        unsigned int get_tx_no() { return _tx_no; }
-        float get_tx_fee() { return _tx_fee; }
-        float get_broadcast_time() { return _broadcast_time; }
-        float get_confirmation_time() { return _confirmation_time; }
-        void set_confirmation_time(float conf_time) { _confirmation_time = conf_time; }
-    private:
-        unsigned int _tx_no;
-        float _tx_fee;
-        float _broadcast_time;
-        float _confirmation_time;
-} Transaction;
+// kinds of changes to a node's state that the optimistic engine can undo; a
+// bitset change is undone by flipping the bit back
+enum UndoKind { UNDO_SEEN_TX, UNDO_KNOWN_TX, UNDO_KNOWN_BLOCK, UNDO_IN_TRANSIT_TX, UNDO_IN_TRANSIT_BLOCK,
+                UNDO_MEMPOOL_INSERT, UNDO_MEMPOOL_ERASE, UNDO_MEMPOOL_DROP, UNDO_BLOCK_PUSH, UNDO_BLOCK_DROP };
 
+// A block's header (its number, time, reward and a summary of its txs) and
+// its body, the tx numbers.  Once every node has a block, the block store may
+// free the body; the header is all that fee decisions need.
 typedef struct Block {
     public:
-        Block(unsigned int block_no, vector<Transaction>* transactions, float block_time, float block_reward) {
-            _block_no = block_no;
-            _transactions = transactions;
-            _block_time = block_time;
-            _block_reward = block_reward;
-        }
+        Block(unsigned int block_no, vector<unsigned int>* transactions, double block_time, float block_reward,
+              const TxTable* tx_table);
+        Block(SnapshotReader& in); // a block saved by save
+        void save(SnapshotWriter& out);
         unsigned int get_block_no() { return _block_no; }
-        vector<Transaction>* get_transactions() { return _transactions; }
-        float get_block_time() { return _block_time; }
+        vector<unsigned int>* get_transactions() { return _transactions; } // tx numbers; NULL once pruned
+        double get_block_time() { return _block_time; }
         float get_block_reward() { return _block_reward; }
+        unsigned int get_num_transactions() { return _num_transactions; }
+        double get_avg_ttc() { return _avg_ttc; } // of the txs in the block, at the block's time
+        float get_avg_tx_fee() { return _avg_tx_fee; }
+        int get_receivers() { return _receivers; }
+        void received(int delta) { _receivers += delta; } // delta nodes have (or, if negative, no longer have) the block
+        void prune() { // free the body
+            delete _transactions;
+            _transactions = NULL;
+        }
     private:
         unsigned int _block_no;
-        vector<Transaction>* _transactions;
-        float _block_time;
+        vector<unsigned int>* _transactions;
+        double _block_time;
         float _block_reward;
+        unsigned int _num_transactions;
+        double _avg_ttc;
+        float _avg_tx_fee;
+        atomic<int> _receivers; // nodes that have accepted the block, from every partition
 } Block;
 
 class Node {
     public:
-        Node(Type type, unsigned int node_no);
+        Node(unsigned int node_no, const Network* network, TxTable* tx_table, BlockStore* block_store, BatchStore* batches,
+             RunStats* stats, Partition* partition, const Parameters* params);
         ~Node();
-        void set_greediness(int greediness) { _greediness = greediness; }
-        int get_greediness() { return _greediness; }
-        Type get_type() const { return _type; }
-        void add_link(Node* otherNode, float speed);
-        unsigned int get_num_links() { return _adj_list->size(); }
+        int get_greediness() const { return _network->get_greediness(_node_no); }
+        Type get_type() const { return _network->get_type(_node_no); }
+        void set_partition(Partition* partition) { _partition = partition; }
         void in_transit_tx(unsigned int tx_no);
         void in_transit_block(unsigned int block_no);
-        void broadcast_transaction(Transaction tx);
-        void broadcast_block(Block* b);
+        bool accept_transaction(unsigned int tx_no); // take in a tx that reached us; false if it is a copy
+        bool accept_block(Block* b); // take in a block that reached us; false if it is a copy
+        void broadcast_transaction(unsigned int tx_no, int from_node = -1); // from_node is -1 for a new tx
+        void broadcast_block(Block* b, int from_node = -1); // from_node is -1 for a new block
+        void flush_transactions(); // send every neighbor a batch of the txs gathered for trickle relay
         unsigned int get_node_no() { return _node_no; }
-        vector<Transaction>* get_known_transactions() { return new vector<Transaction>(*_known_transactions); }
-        vector<Block*>* get_known_blocks() { return new vector<Block*>(*_known_blocks); }
-        bool aware_of(Transaction tx);
+        Block* get_last_block() { return _known_blocks.empty() ? NULL : _known_blocks.back(); } // the latest to reach us
+        bool aware_of_tx(unsigned int tx_no);
         bool aware_of(Block* b);
-        bool linked_to(unsigned int node_no);
-        vector<Transaction>* get_block_transactions(unsigned int block_no);
-        float decide_tx_fee();
-        vector<Transaction>* decide_included_tx_list(float block_reward, float block_time);
+        float decide_tx_fee(Block* last_block); // last_block is the latest block to reach us, or NULL
+        vector<unsigned int>* decide_included_tx_list(float block_reward, double block_time);
+        void undo(int kind, unsigned int no); // revert a change saved in our partition's log
+        unsigned int oldest_relayed_tx(unsigned int floor) const; // the lowest of floor and the txs gathered for our next batch
+        unsigned int oldest_pooled_tx(unsigned int floor) const; // the lowest of floor and the txs in our mempool
+        void trim(unsigned int tx_floor, unsigned int block_floor); // forget the txs and blocks below these, which can no longer reach us
+        void save(SnapshotWriter& out) const;
+        void restore(SnapshotReader& in); // into a new node, after the block store
     private:
         friend ostream& operator<<(ostream& os, const Node& n);
-        Type _type;
-        vector<Link*>* _adj_list;
-        vector<Transaction>* _known_transactions;
-        vector<Block*>* _known_blocks;
-        vector<unsigned int>* _in_transit_tx_nos;
-        vector<unsigned int>* _in_transit_block_nos;
+        Bitset& bits(int kind); // the bitset changed by an UNDO_* bitset kind
+        void mark(int kind, unsigned int no, bool value); // set a bit of a bitset, saving the change
+        TxTable* _tx_table;
+        BlockStore* _block_store; // for blocks dropped from _known_blocks that a rollback puts back
+        BatchStore* _batches; // txs on their way with relay = trickle
+        RunStats* _stats; // of the run this node belongs to, for statistics of new txs and blocks
+        Partition* _partition; // the partition this node belongs to, for relay events
+        const Parameters* _params;
+        const Network* _network; // our type, greediness and links, and the other nodes
+        Mempool* _known_transactions;
+        deque<Block*> _known_blocks; // the latest blocks_kept to reach us (all of them if blocks_kept is 0)
+        Bitset _known_tx_nos; // tx numbers in _known_transactions, or dropped from it by mempool_cap
+        Bitset _known_block_nos; // block numbers of every block that reached us
+        Bitset _in_transit_tx_nos;
+        Bitset _in_transit_block_nos;
+        Bitset _seen_tx_nos; // every tx number ever received, with relay = gossip or trickle
+        // a tx gathered for our next batch, with relay = trickle
+        struct Trickled {
+            unsigned int tx_no;
+            int from_node;
+            double time; // when it reached us
+        };
+        vector<Trickled> _trickle; // in arrival order
+        void post_flush(); // schedule our next batch
         unsigned int _node_no;
-        int _greediness;
 };
 
+#endif
@@ -0,0 +1,204 @@
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include "Parameters.h"
+
+Parameters::Parameters() {
+    this->min_links_per_node = 4;
+    this->mean_tx_interarrival = 10;
+    this->mean_block_interarrival = 100;
+    this->mean_link_speed = 2;
+    this->num_nodes = 20;
+    this->miner_fraction = 0.1;
+    this->max_blocks = 200;
+    this->default_fee = 0.01;
+    this->default_block_reward = 25.0;
+    this->blocks_between_reward_changes = 10;
+    this->event_list_kind = EVENTS_HEAP;
+    this->relay_policy = RELAY_PEEK;
+    this->trickle_interval = 1;
+    this->partitions = 1;
+    this->engine = ENGINE_CONSERVATIVE;
+    this->propagation = PROPAGATION_EVENTS;
+    this->topology = TOPOLOGY_RANDOM;
+    this->rewire_probability = 0.1;
+    this->regions = 6;
+    this->blocks_kept = 0;
+    this->mempool_cap = 0;
+    this->miner_greediness = 0;
+}
+
+const vector<string>& Parameters::names() {
+    static const char* list[] = { "min_links_per_node", "mean_tx_interarrival", "mean_block_interarrival",
+                                  "mean_link_speed", "num_nodes", "miner_fraction", "max_blocks", "default_fee",
+                                  "default_block_reward", "blocks_between_reward_changes", "event_list", "relay",
+                                  "trickle_interval", "partitions", "engine", "propagation", "topology",
+                                  "rewire_probability", "regions", "blocks_kept", "mempool_cap", "miner_greediness" };
+    static const vector<string> names(list, list + sizeof(list) / sizeof(list[0]));
+    return names;
+}
+
+// parse a whole string as a number, failing on trailing garbage
+static bool parse_number(const string& value, double& number) {
+    char* end;
+    number = strtod(value.c_str(), &end);
+    return !value.empty() && *end == '\0';
+}
+
+// parse a whole string as an int, failing on trailing garbage (a fraction
+// included) and on values out of range
+static bool parse_integer(const string& value, int& number) {
+    char* end;
+    errno = 0;
+    long n = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || errno != 0 || n < INT_MIN || n > INT_MAX) return false;
+    number = n;
+    return true;
+}
+
+bool Parameters::set(const string& name, const string& value) {
+    if (name == "event_list") {
+        if (value == "heap") {
+            this->event_list_kind = EVENTS_HEAP;
+        } else if (value == "calendar") {
+            this->event_list_kind = EVENTS_CALENDAR;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (name == "relay") {
+        if (value == "peek") {
+            this->relay_policy = RELAY_PEEK;
+        } else if (value == "gossip") {
+            this->relay_policy = RELAY_GOSSIP;
+        } else if (value == "trickle") {
+            this->relay_policy = RELAY_TRICKLE;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (name == "engine") {
+        if (value == "conservative") {
+            this->engine = ENGINE_CONSERVATIVE;
+        } else if (value == "optimistic") {
+            this->engine = ENGINE_OPTIMISTIC;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (name == "propagation") {
+        if (value == "events") {
+            this->propagation = PROPAGATION_EVENTS;
+        } else if (value == "analytic") {
+            this->propagation = PROPAGATION_ANALYTIC;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (name == "topology") {
+        if (value == "random") {
+            this->topology = TOPOLOGY_RANDOM;
+        } else if (value == "regular") {
+            this->topology = TOPOLOGY_REGULAR;
+        } else if (value == "scale_free") {
+            this->topology = TOPOLOGY_SCALE_FREE;
+        } else if (value == "small_world") {
+            this->topology = TOPOLOGY_SMALL_WORLD;
+        } else if (value == "geographic") {
+            this->topology = TOPOLOGY_GEOGRAPHIC;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    int* integer = NULL;
+    if (name == "min_links_per_node") integer = &this->min_links_per_node;
+    else if (name == "num_nodes") integer = &this->num_nodes;
+    else if (name == "max_blocks") integer = &this->max_blocks;
+    else if (name == "blocks_between_reward_changes") integer = &this->blocks_between_reward_changes;
+    else if (name == "partitions") integer = &this->partitions;
+    else if (name == "regions") integer = &this->regions;
+    else if (name == "blocks_kept") integer = &this->blocks_kept;
+    else if (name == "mempool_cap") integer = &this->mempool_cap;
+    else if (name == "miner_greediness") integer = &this->miner_greediness;
+    if (integer != NULL) return parse_integer(value, *integer);
+    double number;
+    if (!parse_number(value, number)) return false;
+    if (name == "mean_tx_interarrival") this->mean_tx_interarrival = number;
+    else if (name == "mean_block_interarrival") this->mean_block_interarrival = number;
+    else if (name == "mean_link_speed") this->mean_link_speed = number;
+    else if (name == "miner_fraction") this->miner_fraction = number;
+    else if (name == "default_fee") this->default_fee = number;
+    else if (name == "default_block_reward") this->default_block_reward = number;
+    else if (name == "trickle_interval") this->trickle_interval = number;
+    else if (name == "rewire_probability") this->rewire_probability = number;
+    else return false;
+    return true;
+}
+
+string Parameters::get(const string& name) const {
+    char buf[32];
+    if (name == "event_list") return this->event_list_kind == EVENTS_CALENDAR ? "calendar" : "heap";
+    else if (name == "relay") {
+        static const char* policies[] = { "", "peek", "gossip", "trickle" };
+        return policies[this->relay_policy];
+    }
+    else if (name == "engine") return this->engine == ENGINE_OPTIMISTIC ? "optimistic" : "conservative";
+    else if (name == "propagation") return this->propagation == PROPAGATION_ANALYTIC ? "analytic" : "events";
+    else if (name == "topology") {
+        static const char* topologies[] = { "", "random", "regular", "scale_free", "small_world", "geographic" };
+        return topologies[this->topology];
+    }
+    else if (name == "min_links_per_node") snprintf(buf, sizeof(buf), "%d", this->min_links_per_node);
+    else if (name == "mean_tx_interarrival") snprintf(buf, sizeof(buf), "%g", this->mean_tx_interarrival);
+    else if (name == "mean_block_interarrival") snprintf(buf, sizeof(buf), "%g", this->mean_block_interarrival);
+    else if (name == "mean_link_speed") snprintf(buf, sizeof(buf), "%g", this->mean_link_speed);
+    else if (name == "num_nodes") snprintf(buf, sizeof(buf), "%d", this->num_nodes);
+    else if (name == "miner_fraction") snprintf(buf, sizeof(buf), "%g", this->miner_fraction);
+    else if (name == "max_blocks") snprintf(buf, sizeof(buf), "%d", this->max_blocks);
+    else if (name == "default_fee") snprintf(buf, sizeof(buf), "%g", this->default_fee);
+    else if (name == "default_block_reward") snprintf(buf, sizeof(buf), "%g", this->default_block_reward);
+    else if (name == "blocks_between_reward_changes") snprintf(buf, sizeof(buf), "%d", this->blocks_between_reward_changes);
+    else if (name == "trickle_interval") snprintf(buf, sizeof(buf), "%g", this->trickle_interval);
+    else if (name == "partitions") snprintf(buf, sizeof(buf), "%d", this->partitions);
+    else if (name == "rewire_probability") snprintf(buf, sizeof(buf), "%g", this->rewire_probability);
+    else if (name == "regions") snprintf(buf, sizeof(buf), "%d", this->regions);
+    else if (name == "blocks_kept") snprintf(buf, sizeof(buf), "%d", this->blocks_kept);
+    else if (name == "mempool_cap") snprintf(buf, sizeof(buf), "%d", this->mempool_cap);
+    else if (name == "miner_greediness") snprintf(buf, sizeof(buf), "%d", this->miner_greediness);
+    else return "";
+    return buf;
+}
+
+const char* Parameters::check() const {
+    if (this->num_nodes < 2) return "num_nodes must be at least 2";
+    if ((int)(this->miner_fraction * this->num_nodes) < 1) return "miner_fraction * num_nodes must be at least 1";
+    if (this->min_links_per_node < 0 || this->min_links_per_node >= this->num_nodes)
+        return "min_links_per_node must be between 0 and num_nodes - 1";
+    if (this->max_blocks < 1) return "max_blocks must be at least 1";
+    if (this->blocks_between_reward_changes < 1) return "blocks_between_reward_changes must be at least 1";
+    if (this->mean_tx_interarrival <= 0 || this->mean_block_interarrival <= 0 || this->mean_link_speed <= 0)
+        return "mean interarrival times and link speed must be positive";
+    if (this->partitions < 1 || this->partitions > this->num_nodes) return "partitions must be between 1 and num_nodes";
+    if (this->partitions > 1 && this->relay_policy == RELAY_PEEK)
+        return "more than one partition needs relay = gossip or trickle, since senders cannot see other partitions' nodes";
+    if (this->trickle_interval <= 0) return "trickle_interval must be positive";
+    if (this->partitions > 1 && this->engine == ENGINE_OPTIMISTIC && this->relay_policy == RELAY_TRICKLE)
+        return "the optimistic engine cannot roll back the tx batches of relay = trickle";
+    if (this->propagation == PROPAGATION_ANALYTIC && (this->relay_policy != RELAY_GOSSIP || this->partitions != 1))
+        return "propagation = analytic needs relay = gossip and a single partition";
+    if (this->rewire_probability < 0 || this->rewire_probability > 1) return "rewire_probability must be between 0 and 1";
+    if (this->regions < 1) return "regions must be at least 1";
+    if (this->blocks_kept < 0) return "blocks_kept must not be negative";
+    if (this->blocks_kept > 0 && (this->propagation == PROPAGATION_ANALYTIC ||
+                                  (this->partitions > 1 && this->engine == ENGINE_OPTIMISTIC)))
+        return "blocks_kept needs propagation = events and, with partitions, the conservative engine";
+    if (this->mempool_cap < 0) return "mempool_cap must not be negative";
+    if (this->miner_greediness < 0 || this->miner_greediness > 100) return "miner_greediness must be between 0 and 100";
+    return NULL;
+}
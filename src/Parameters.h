@@ -0,0 +1,59 @@
+
+// The inputs of one simulation run.  A parameter point of a study is one
+// Parameters value; replications of the point differ only in their seed.
+// Every parameter has a name, used in scenario files and in result rows.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "simlibdefs.h"
+
+#ifndef PARAMETERS_H
+#define PARAMETERS_H
+
+#define RELAY_PEEK 1 // senders skip neighbors that know of (or are being sent) the tx or block
+#define RELAY_GOSSIP 2 // senders tell every neighbor but their own sender; receivers drop copies
+#define RELAY_TRICKLE 3 // like gossip, but txs are gathered and sent in batches every trickle_interval
+#define ENGINE_CONSERVATIVE 1 // partitions advance in windows no longer than the lookahead
+#define ENGINE_OPTIMISTIC 2 // partitions run ahead and roll back on stragglers (Time Warp)
+#define PROPAGATION_EVENTS 1 // every relay over every link is an event
+#define PROPAGATION_ANALYTIC 2 // arrival times are worked out from shortest paths; see Propagation.h
+#define TOPOLOGY_RANDOM 1 // every node links to random nodes until it has min_links_per_node links
+#define TOPOLOGY_REGULAR 2 // see Topology.h for these
+#define TOPOLOGY_SCALE_FREE 3
+#define TOPOLOGY_SMALL_WORLD 4
+#define TOPOLOGY_GEOGRAPHIC 5
+
+using namespace std;
+
+struct Parameters {
+    Parameters();
+    static const vector<string>& names(); // every parameter name, in result column order
+    bool set(const string& name, const string& value); // false if the name or value is not valid
+    string get(const string& name) const;
+    const char* check() const; // describes why the point cannot be run, or NULL if it can
+    int min_links_per_node;
+    float mean_tx_interarrival;
+    float mean_block_interarrival;
+    float mean_link_speed;
+    int num_nodes; // total number of nodes on the network
+    float miner_fraction; // fraction of the nodes that are miners (rather than relay nodes)
+    int max_blocks; // the simulation will be stopped after this many blocks are mined
+    float default_fee; // default value for transaction fees
+    float default_block_reward; // default reward for miners when they mine a block
+    int blocks_between_reward_changes; // number of blocks between changes in block reward amount
+    int event_list_kind; // EVENTS_HEAP or EVENTS_CALENDAR
+    int relay_policy; // RELAY_PEEK, RELAY_GOSSIP or RELAY_TRICKLE
+    float trickle_interval; // time between a node's tx batches, with relay = trickle
+    int partitions; // threads that advance one run's network side by side
+    int engine; // ENGINE_CONSERVATIVE or ENGINE_OPTIMISTIC, for partitions > 1
+    int propagation; // PROPAGATION_EVENTS or PROPAGATION_ANALYTIC
+    int topology; // TOPOLOGY_*: how links are made
+    float rewire_probability; // chance that a small-world link goes to a random node
+    int regions; // regions of a geographic topology
+    int blocks_kept; // blocks a node keeps, the latest; 0 keeps them all
+    int mempool_cap; // txs a mempool holds before it drops its lowest-fee tx; 0 for no cap
+    int miner_greediness; // greediness of every miner, 1 to 100; 0 draws each miner's at random
+};
+
+#endif
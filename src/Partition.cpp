@@ -0,0 +1,165 @@
+
+#include <math.h>
+#include <algorithm>
+#include "Partition.h"
+#include "Node.h"
+#include "blockchain-sim-defs.h"
+
+Partition::Partition(unsigned int index, unsigned int num_partitions, const vector<Partition*>* partitions,
+                     const vector<unsigned int>* owner, int event_list_kind, bool optimistic) : sl() {
+    this->_index = index;
+    this->_partitions = partitions;
+    this->_owner = owner;
+    this->_optimistic = optimistic;
+    this->_next_message = (long)index << 40;
+    this->_gvt = 0;
+    this->_undo_base = 0;
+    this->_sent_base = 0;
+    this->logging = false;
+    this->events = 0;
+    this->mempool_txs = 0;
+    this->mempool_drops = 0;
+    this->rolled_back = 0;
+    this->trace = NULL;
+    if (!optimistic) this->outbox.resize(num_partitions);
+    this->sl.event_list_kind = event_list_kind;
+    init_simlib(&this->sl);
+}
+
+void Partition::post(struct event& ev, unsigned int to_node) {
+    unsigned int dest = (*this->_owner)[to_node];
+    if (!this->_optimistic) {
+        if (dest == this->_index) event_post(&this->sl, &ev);
+        else this->outbox[dest].push_back(ev);
+        return;
+    }
+    long message = this->_next_message++;
+    ev.id[MESSAGE_ID] = message;
+    if (dest == this->_index) {
+        this->_pending[message] = event_post(&this->sl, &ev);
+    } else {
+        Message m = { ev, false };
+        (*this->_partitions)[dest]->inbox.push(m);
+    }
+    if (this->logging) this->_sent.push_back(Sent { dest, message, ev.time });
+}
+
+void Partition::deliver() {
+    for (vector<Partition*>::const_iterator it = this->_partitions->begin(); it != this->_partitions->end(); ++it) {
+        if ((*it)->outbox.empty()) continue;
+        vector<struct event>& inbox = (*it)->outbox[this->_index];
+        for (vector<struct event>::iterator ev = inbox.begin(); ev != inbox.end(); ++ev) {
+            event_post(&this->sl, &*ev);
+        }
+        inbox.clear();
+    }
+}
+
+// the lowest tx and block numbers of the relay events visited
+struct Relayed {
+    unsigned int tx_no, block_no;
+};
+
+static void lower_to_relayed(const struct event* ev, void* arg) {
+    Relayed* relayed = (Relayed*)arg;
+    if (ev->type == EVENT_TX_RELAY) relayed->tx_no = min(relayed->tx_no, (unsigned int)ev->id[0]);
+    if (ev->type == EVENT_BLOCK_RELAY) relayed->block_no = min(relayed->block_no, (unsigned int)ev->id[0]);
+}
+
+void Partition::oldest_relayed(unsigned int& tx_no, unsigned int& block_no) {
+    // the outboxes are empty between global events
+    Relayed relayed = { tx_no, block_no };
+    event_visit(&this->sl, lower_to_relayed, &relayed);
+    tx_no = relayed.tx_no;
+    block_no = relayed.block_no;
+}
+
+void Partition::save(SnapshotWriter& out) {
+    // the outboxes are empty between global events
+    out.put_simlib(&this->sl);
+    out.put(this->events);
+    out.put(this->mempool_txs);
+    out.put(this->mempool_drops);
+    out.put(this->rolled_back);
+}
+
+void Partition::restore(SnapshotReader& in) {
+    in.get_simlib(&this->sl);
+    this->events = in.get<long>();
+    this->mempool_txs = in.get<long>();
+    this->mempool_drops = in.get<long>();
+    this->rolled_back = in.get<long>();
+}
+
+bool Partition::next(struct event& ev, double until) {
+    if (event_time(&this->sl) >= until) return false;
+    event_next(&this->sl, &ev);
+    this->_pending.erase(ev.id[MESSAGE_ID]);
+    Processed p = { ev, this->_undo_base + this->_undo.size(), this->_sent_base + this->_sent.size() };
+    this->_processed.push_back(p);
+    return true;
+}
+
+void Partition::receive() {
+    if (this->inbox.empty()) return;
+    vector<Message> messages;
+    this->inbox.take(messages);
+    for (vector<Message>::iterator m = messages.begin(); m != messages.end(); ++m) {
+        long message = m->ev.id[MESSAGE_ID];
+        if (m->anti) {
+            // annihilate the relay, first rolling back past it if it was already processed
+            if (this->_pending.find(message) == this->_pending.end()) this->rollback(m->ev.time, true);
+            event_cancel(&this->sl, this->_pending[message]);
+            this->_pending.erase(message);
+        } else {
+            if (!this->_processed.empty() && m->ev.time < this->_processed.back().ev.time) {
+                this->rollback(m->ev.time, false); // a straggler
+            }
+            this->_pending[message] = event_post(&this->sl, &m->ev);
+        }
+    }
+}
+
+void Partition::rollback(double time, bool inclusive) {
+    while (!this->_processed.empty()
+           && (this->_processed.back().ev.time > time || (inclusive && this->_processed.back().ev.time == time))) {
+        Processed& p = this->_processed.back();
+        // undo its changes to our nodes, latest first
+        while (this->_undo_base + this->_undo.size() > p.first_undo) {
+            UndoEntry& u = this->_undo.back();
+            u.node->undo(u.kind, u.no);
+            this->_undo.pop_back();
+        }
+        // cancel the relays it sent; any of ours it caused were rolled back (and filed again) already
+        while (this->_sent_base + this->_sent.size() > p.first_sent) {
+            Sent& s = this->_sent.back();
+            if (s.dest == this->_index) {
+                event_cancel(&this->sl, this->_pending[s.message]);
+                this->_pending.erase(s.message);
+            } else {
+                Message anti;
+                anti.ev.time = s.time;
+                anti.ev.id[MESSAGE_ID] = s.message;
+                anti.anti = true;
+                (*this->_partitions)[s.dest]->inbox.push(anti);
+            }
+            this->_sent.pop_back();
+        }
+        // and run it again
+        this->_pending[p.ev.id[MESSAGE_ID]] = event_post(&this->sl, &p.ev);
+        this->_processed.pop_back();
+        ++this->rolled_back;
+    }
+    this->sl.sim_time = this->_processed.empty() ? this->_gvt : this->_processed.back().ev.time;
+}
+
+void Partition::fossil_collect(double gvt) {
+    while (!this->_processed.empty() && this->_processed.front().ev.time < gvt) this->_processed.pop_front();
+    size_t undo_end = this->_processed.empty() ? this->_undo_base + this->_undo.size() : this->_processed.front().first_undo;
+    size_t sent_end = this->_processed.empty() ? this->_sent_base + this->_sent.size() : this->_processed.front().first_sent;
+    this->_undo.erase(this->_undo.begin(), this->_undo.begin() + (undo_end - this->_undo_base));
+    this->_sent.erase(this->_sent.begin(), this->_sent.begin() + (sent_end - this->_sent_base));
+    this->_undo_base = undo_end;
+    this->_sent_base = sent_end;
+    this->_gvt = max(this->_gvt, gvt);
+}
@@ -0,0 +1,107 @@
+
+// A share of the network's nodes whose relay events are kept on their own
+// simlib event list, so that partitions can be advanced side by side by
+// different threads.
+//
+// With the conservative engine, a relay event for a node of another partition
+// is put in the outbox for that partition instead; each outbox has a single
+// writer (its partition, while a window runs) and a single reader (the
+// destination, after the window's barrier), so no locks are needed.
+//
+// With the optimistic engine (Time Warp), a partition runs its relay events
+// without waiting for the others and sends relays across partitions at once,
+// through the destination's lock-free inbox.  Every relay event carries a
+// message number in id[MESSAGE_ID].  While it runs, the partition keeps a log
+// of the events it processed, the node state changes each one made and the
+// messages each one sent.  A straggler (a relay earlier than events already
+// processed) rolls the partition back: the later events' changes are undone,
+// their messages are cancelled (by anti-messages, across partitions) and the
+// events are filed again.  Log entries earlier than the global virtual time
+// (GVT), before which nothing can be rolled back, are discarded.
+
+#include <stdint.h>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "MpscQueue.h"
+#include "simlib.h"
+#include "Snapshot.h"
+
+#ifndef PARTITION_H
+#define PARTITION_H
+
+using namespace std;
+
+class Node;
+class TraceBuffer;
+
+// a change to a node's state, saved so it can be undone; see Node::undo
+struct UndoEntry {
+    Node* node;
+    int kind; // UNDO_* in Node.h
+    unsigned int no; // tx or block number
+};
+
+// a relay event sent to another partition by the optimistic engine, or the
+// anti-message that cancels it (with the time and message number of the relay)
+struct Message {
+    struct event ev;
+    bool anti;
+};
+
+class Partition {
+    public:
+        Partition(unsigned int index, unsigned int num_partitions, const vector<Partition*>* partitions,
+                  const vector<unsigned int>* owner, int event_list_kind, bool optimistic);
+        ~Partition() { free_simlib(&sl); }
+        unsigned int get_index() { return _index; }
+        void post(struct event& ev, unsigned int to_node); // schedule a relay event for node to_node
+        void deliver(); // file the events other partitions put in their outboxes for our nodes
+        void oldest_relayed(unsigned int& tx_no, unsigned int& block_no); // lower them to those of our pending relays
+        void save(SnapshotWriter& out); // between global events, with the conservative engine
+        void restore(SnapshotReader& in); // into a new partition
+
+        // optimistic engine
+        void save(Node* node, int kind, unsigned int no) { // log a change to node, if it may be rolled back
+            if (logging) _undo.push_back(UndoEntry { node, kind, no });
+        }
+        bool next(struct event& ev, double until); // take the next relay event earlier than until, logging it
+        void receive(); // file the messages in our inbox, rolling back for stragglers and anti-messages
+        void fossil_collect(double gvt); // forget the log earlier than gvt, which is final
+
+        struct simlib sl;
+        vector<vector<struct event> > outbox; // indexed by destination partition
+        MpscQueue<Message> inbox;
+        bool logging; // processed events are being logged, so node changes must be saved
+        long events; // relay events run
+        long mempool_txs; // txs in the mempools of our nodes
+        long mempool_drops; // txs our nodes dropped from full mempools
+        long rolled_back; // events undone by rollbacks
+        TraceBuffer* trace; // records what our nodes receive, if the run is traced
+    private:
+        // an event processed optimistically; its undo entries and sent messages
+        // follow in _undo and _sent from the given absolute positions
+        struct Processed {
+            struct event ev;
+            size_t first_undo, first_sent;
+        };
+        struct Sent {
+            unsigned int dest;
+            long message;
+            double time;
+        };
+        void rollback(double time, bool inclusive); // undo the events later than (or, if inclusive, at) time
+        unsigned int _index;
+        const vector<Partition*>* _partitions;
+        const vector<unsigned int>* _owner; // partition of every node
+        bool _optimistic;
+        long _next_message;
+        double _gvt; // the log holds no events earlier than this
+        unordered_map<long, long long> _pending; // event list handle of every pending relay, by message number
+        deque<Processed> _processed;
+        deque<UndoEntry> _undo;
+        deque<Sent> _sent;
+        size_t _undo_base, _sent_base; // absolute positions of the fronts of _undo and _sent
+};
+
+#endif
@@ -0,0 +1,117 @@
+
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include "Propagation.h"
+
+Propagation::Propagation(const Network* network, const TxTable* tx_table) {
+    this->_network = network;
+    this->_tx_table = tx_table;
+    this->_landed = NULL;
+    this->_distance_from = -1;
+}
+
+void Propagation::transaction(unsigned int tx_no, unsigned int origin) {
+    if (tx_no >= this->_tx_origin.size()) this->_tx_origin.resize(tx_no + 1);
+    this->_tx_origin[tx_no] = origin;
+}
+
+void Propagation::shortest_paths(unsigned int from) {
+    const Network* network = this->_network;
+    this->_distance.assign(network->size(), INFINITY);
+    priority_queue<pair<double, unsigned int>, vector<pair<double, unsigned int> >,
+                   greater<pair<double, unsigned int> > > frontier;
+    this->_distance[from] = 0;
+    frontier.push(make_pair(0.0f, from));
+    while (!frontier.empty()) {
+        double distance = frontier.top().first;
+        unsigned int node = frontier.top().second;
+        frontier.pop();
+        if (distance > this->_distance[node]) continue; // already reached by a shorter path
+        for (unsigned int link = network->links_begin(node); link != network->links_end(node); ++link) {
+            unsigned int other = network->neighbor(link);
+            double through = distance + network->speed(link);
+            if (through < this->_distance[other]) {
+                this->_distance[other] = through;
+                frontier.push(make_pair(through, other));
+            }
+        }
+    }
+    this->_distance_from = from;
+}
+
+void Propagation::catch_up(Node* miner, double now) {
+    unsigned int miner_no = miner->get_node_no();
+    this->shortest_paths(miner_no);
+    Backlog& backlog = this->_backlogs[miner_no];
+    for (; backlog.next_tx < this->_tx_table->size(); ++backlog.next_tx) backlog.tx_nos.push_back(backlog.next_tx);
+    for (; backlog.next_block < this->_blocks.size(); ++backlog.next_block) backlog.blocks.push_back(backlog.next_block);
+
+    // find what has arrived, by (time, blocks before txs, number); keep the rest for later
+    vector<pair<double, pair<int, unsigned int> > > arrived;
+    size_t kept = 0;
+    for (size_t i = 0; i < backlog.tx_nos.size(); ++i) {
+        unsigned int tx_no = backlog.tx_nos[i];
+        double arrival = this->_tx_table->get_broadcast_time(tx_no) + this->_distance[this->_tx_origin[tx_no]];
+        if (arrival <= now) arrived.push_back(make_pair(arrival, make_pair(1, tx_no)));
+        else backlog.tx_nos[kept++] = tx_no;
+    }
+    backlog.tx_nos.resize(kept);
+    kept = 0;
+    for (size_t i = 0; i < backlog.blocks.size(); ++i) {
+        unsigned int index = backlog.blocks[i];
+        double arrival = this->_blocks[index]->get_block_time() + 2 * this->_distance[this->_block_miner[index]];
+        if (arrival <= now) arrived.push_back(make_pair(arrival, make_pair(0, index)));
+        else backlog.blocks[kept++] = index;
+    }
+    backlog.blocks.resize(kept);
+
+    sort(arrived.begin(), arrived.end());
+    for (size_t i = 0; i < arrived.size(); ++i) {
+        if (arrived[i].second.first == 0) miner->accept_block(this->_blocks[arrived[i].second.second]);
+        else miner->accept_transaction(arrived[i].second.second);
+    }
+}
+
+void Propagation::mined(Block* b, unsigned int miner) {
+    this->_blocks.push_back(b);
+    this->_block_miner.push_back(miner);
+    if (this->_distance_from != (int)miner) this->shortest_paths(miner);
+
+    // the block is on its way until it reaches the farthest node it can
+    Flight flight;
+    flight.block = b;
+    flight.landed = b->get_block_time();
+    for (vector<double>::iterator it = this->_distance.begin(); it != this->_distance.end(); ++it) {
+        if (*it != INFINITY) flight.landed = max(flight.landed, b->get_block_time() + 2 * *it);
+    }
+    this->_flights.push_back(flight);
+    this->_flights.back().distance.swap(this->_distance);
+    this->_distance_from = -1;
+}
+
+void Propagation::land(double now) {
+    for (deque<Flight>::iterator it = this->_flights.begin(); it != this->_flights.end();) {
+        if (it->landed > now) {
+            ++it;
+            continue;
+        }
+        if (this->_landed == NULL || it->block->get_block_no() > this->_landed->get_block_no()) this->_landed = it->block;
+        it = this->_flights.erase(it);
+    }
+}
+
+Block* Propagation::last_block(unsigned int node_no, double now) {
+    this->land(now);
+    Block* last = NULL;
+    double last_arrival = -INFINITY;
+    for (deque<Flight>::iterator it = this->_flights.begin(); it != this->_flights.end(); ++it) {
+        double arrival = it->block->get_block_time() + 2 * it->distance[node_no];
+        if (arrival <= now && arrival > last_arrival) {
+            last = it->block;
+            last_arrival = arrival;
+        }
+    }
+    return last != NULL ? last : this->_landed;
+}
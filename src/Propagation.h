@@ -0,0 +1,64 @@
+
+// Analytic propagation (propagation = analytic).  With relay = gossip a
+// transaction or block floods the network, so it reaches each node at its
+// origin time plus the shortest-path distance from its origin, counting every
+// link's latency once for a transaction and twice for a block.  Instead of
+// one relay event per link, these arrival times are worked out only where they
+// are needed:
+//
+// - When a miner builds a block, a Dijkstra pass from the miner gives its
+//   distance to every origin (links are the same both ways).  Every
+//   transaction and block that reached the miner since it last mined is then
+//   taken in, in the order it arrived.
+// - The same distances give the new block's arrival time at every node.  They
+//   are kept until the block has reached every node, and tell the fee
+//   decisions of other nodes which block reached them last.
+//
+// This differs from simulated gossip in two ways.  A node that already has a
+// block still passes on the block's transactions.  And once every block has
+// reached every node, a node's latest block is taken to be the newest one.
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "Network.h"
+#include "Node.h"
+#include "TxTable.h"
+
+#ifndef PROPAGATION_H
+#define PROPAGATION_H
+
+using namespace std;
+
+class Propagation {
+    public:
+        Propagation(const Network* network, const TxTable* tx_table);
+        void transaction(unsigned int tx_no, unsigned int origin); // a new tx from node origin
+        void catch_up(Node* miner, double now); // take in every tx and block that reached the miner by now
+        void mined(Block* b, unsigned int miner); // a new block from the miner that last caught up
+        Block* last_block(unsigned int node_no, double now); // the latest block to reach the node by now, or NULL
+    private:
+        struct Flight { // a block that has not reached every node yet
+            Block* block;
+            double landed; // when it will have reached every node
+            vector<double> distance; // from its miner to every node
+        };
+        struct Backlog { // what a miner has not taken in yet
+            unsigned int next_tx, next_block; // later txs and blocks have not been looked at
+            vector<unsigned int> tx_nos, blocks; // looked at, but on their way; blocks index _blocks
+        };
+        void shortest_paths(unsigned int from); // Dijkstra over link latencies into _distance
+        void land(double now); // retire the flights that have reached every node by now
+        const Network* _network;
+        const TxTable* _tx_table;
+        vector<unsigned int> _tx_origin; // by tx number
+        vector<Block*> _blocks; // in the order they were mined
+        vector<unsigned int> _block_miner;
+        deque<Flight> _flights;
+        Block* _landed; // the newest block that has reached every node
+        unordered_map<unsigned int, Backlog> _backlogs; // by miner
+        vector<double> _distance;
+        int _distance_from; // the node _distance is from, or -1
+};
+
+#endif
@@ -0,0 +1,203 @@
+
+#include <math.h>
+#include <stdlib.h>
+#include <memory>
+#include "Runner.h"
+#include "ThreadPool.h"
+
+// 97.5th percentile of Student's t distribution with df degrees of freedom,
+// for two-sided 95% confidence intervals
+static double t_975(int df) {
+    static const double table[] = { 0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+                                    2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+                                    2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045,
+                                    2.042 };
+    if (df <= 30) return table[df];
+    if (df <= 40) return 2.021;
+    if (df <= 60) return 2.000;
+    if (df <= 120) return 1.980;
+    return 1.960;
+}
+
+// mean of the samples and the half-width of its 95% confidence interval
+static void mean_ci(const vector<double>& samples, double& mean, double& half_width) {
+    size_t n = samples.size();
+    double sum_squares = 0;
+    mean = 0;
+    for (size_t i = 0; i < n; ++i) mean += samples[i];
+    mean /= n;
+    for (size_t i = 0; i < n; ++i) sum_squares += (samples[i] - mean) * (samples[i] - mean);
+    half_width = 0;
+    if (n > 1) half_width = t_975(n - 1) * sqrt(sum_squares / (n - 1) / n);
+}
+
+static const char* result_names[] = { "avg_ttc", "avg_tx_fee", "confirmed", "eviction_time", "events", "mempool",
+                                      "pending_events", "mempool_drops" };
+static const int num_results = sizeof(result_names) / sizeof(result_names[0]);
+
+// Distributions are pooled across a point's replications by merging their
+// sketches; each gets a standard deviation and quantile columns, with no
+// confidence interval.
+static const char* pooled_names[] = { "ttc", "tx_fee", "mempool", "pending_events" };
+static const int num_pooled = sizeof(pooled_names) / sizeof(pooled_names[0]);
+static const char* pooled_columns[] = { "sd", "p50", "p90", "p99" };
+static const int num_pooled_columns = sizeof(pooled_columns) / sizeof(pooled_columns[0]);
+
+static double pooled_value(const StreamStat& stat, int column) {
+    static const double quantiles[] = { 0, 0.5, 0.9, 0.99 };
+    if (column == 0) return stat.moments.sd();
+    return stat.digest.quantile(quantiles[column]);
+}
+
+Runner::Runner(const vector<Parameters>& points, int replications, uint64_t seed, const Snapshot* start) {
+    this->_points = points;
+    this->_replications = replications;
+    this->_seed = seed;
+    this->_start = start;
+    this->_save_path = NULL;
+    this->_save_at = 0;
+    this->_branch_at = -1;
+    this->_trace_path = NULL;
+}
+
+void Runner::run(unsigned int num_threads, FILE* out, int output) {
+    this->_results.assign(this->_points.size() * this->_replications, Results());
+    this->_remaining.assign(this->_points.size(), this->_replications);
+    this->_next_row = 0;
+
+    this->write_header(out, output);
+    ThreadPool pool(num_threads);
+    if (this->_branch_at >= 0) {
+        // one trunk per replication, whose task starts the branches; its
+        // snapshot is freed when the last branch has started from it
+        for (int r = 0; r < this->_replications; ++r) {
+            uint64_t seed = this->_seed + r;
+            pool.submit([this, r, seed, out, output, &pool]() {
+                Simulation trunk(this->_points[0], seed, this->_start);
+                trunk.run(this->_branch_at);
+                shared_ptr<const Snapshot> start(trunk.snapshot());
+                if (!start) exit(1); // checked before the study, so it does not happen
+                for (size_t p = 0; p < this->_points.size(); ++p) {
+                    pool.submit([this, p, r, seed, out, output, start]() {
+                        Simulation sim(this->_points[p], seed, start.get());
+                        sim.run();
+                        this->finish(p, r, sim.results(), out, output);
+                    });
+                }
+            });
+        }
+        pool.wait();
+        return;
+    }
+    for (size_t p = 0; p < this->_points.size(); ++p) {
+        for (int r = 0; r < this->_replications; ++r) {
+            // replication r gets the same seed at every point (common random numbers),
+            // so differences between points are not masked by seed noise
+            uint64_t seed = this->_seed + r;
+            pool.submit([this, p, r, seed, out, output]() {
+                Simulation sim(this->_points[p], seed, this->_start);
+                if (this->_trace_path != NULL && !sim.trace(this->_trace_path)) exit(1); // reported to stderr
+                if (this->_save_path != NULL) {
+                    sim.run(this->_save_at);
+                    sim.save(this->_save_path);
+                }
+                sim.run();
+                this->finish(p, r, sim.results(), out, output);
+            });
+        }
+    }
+    pool.wait();
+}
+
+void Runner::finish(size_t p, int r, const Results& results, FILE* out, int output) {
+    this->_results[p * this->_replications + r] = results;
+
+    // write out every row that is now complete, in point order
+    lock_guard<mutex> guard(this->_lock);
+    --this->_remaining[p];
+    while (this->_next_row < this->_remaining.size() && this->_remaining[this->_next_row] == 0) {
+        this->write_row(out, output, this->_next_row++);
+    }
+    fflush(out);
+}
+
+void Runner::write_header(FILE* out, int output) {
+    if (output == OUTPUT_JSON) return;
+    const char* sep = output == OUTPUT_CSV ? "," : "\t";
+    const vector<string>& names = Parameters::names();
+    for (size_t i = 0; i < names.size(); ++i) {
+        fprintf(out, "%s%s", names[i].c_str(), sep);
+    }
+    fprintf(out, "replications");
+    for (int i = 0; i < num_results; ++i) {
+        fprintf(out, "%s%s%s%s_ci", sep, result_names[i], sep, result_names[i]);
+    }
+    for (int i = 0; i < num_pooled; ++i) {
+        for (int j = 0; j < num_pooled_columns; ++j) {
+            fprintf(out, "%s%s_%s", sep, pooled_names[i], pooled_columns[j]);
+        }
+    }
+    fprintf(out, "\n");
+}
+
+void Runner::write_row(FILE* out, int output, size_t point) {
+    const Parameters& params = this->_points[point];
+    const vector<string>& names = Parameters::names();
+    vector<double> samples[num_results];
+    RunStats pooled;
+    for (int r = 0; r < this->_replications; ++r) {
+        const Results& res = this->_results[point * this->_replications + r];
+        samples[0].push_back(res.avg_ttc);
+        samples[1].push_back(res.avg_tx_fee);
+        samples[2].push_back(res.confirmed_fraction);
+        samples[3].push_back(res.eviction_time);
+        samples[4].push_back(res.events);
+        samples[5].push_back(res.mempool);
+        samples[6].push_back(res.pending_events);
+        samples[7].push_back(res.mempool_drops);
+        pooled.merge(res.stats);
+    }
+    const StreamStat* pooled_stats[] = { &pooled.ttc, &pooled.tx_fee, &pooled.mempool.stat, &pooled.pending_events.stat };
+
+    if (output == OUTPUT_JSON) {
+        fprintf(out, "{");
+        for (size_t i = 0; i < names.size(); ++i) {
+            // numbers as they are, names of choices (event_list, relay, ...) as strings
+            string value = params.get(names[i]);
+            char* end;
+            strtod(value.c_str(), &end);
+            const char* quote = *end == '\0' ? "" : "\"";
+            fprintf(out, "\"%s\": %s%s%s, ", names[i].c_str(), quote, value.c_str(), quote);
+        }
+        fprintf(out, "\"replications\": %d", this->_replications);
+        for (int i = 0; i < num_results; ++i) {
+            double mean, half_width;
+            mean_ci(samples[i], mean, half_width);
+            fprintf(out, ", \"%s\": %f, \"%s_ci\": %f", result_names[i], mean, result_names[i], half_width);
+        }
+        for (int i = 0; i < num_pooled; ++i) {
+            for (int j = 0; j < num_pooled_columns; ++j) {
+                fprintf(out, ", \"%s_%s\": %f", pooled_names[i], pooled_columns[j], pooled_value(*pooled_stats[i], j));
+            }
+        }
+        fprintf(out, "}\n");
+        return;
+    }
+
+    const char* sep = output == OUTPUT_CSV ? "," : "\t";
+    for (size_t i = 0; i < names.size(); ++i) {
+        fprintf(out, "%s%s", params.get(names[i]).c_str(), sep);
+    }
+    fprintf(out, "%d", this->_replications);
+    for (int i = 0; i < num_results; ++i) {
+        double mean, half_width;
+        mean_ci(samples[i], mean, half_width);
+        fprintf(out, "%s%f%s%f", sep, mean, sep, half_width);
+    }
+    for (int i = 0; i < num_pooled; ++i) {
+        for (int j = 0; j < num_pooled_columns; ++j) {
+            fprintf(out, "%s%f", sep, pooled_value(*pooled_stats[i], j));
+        }
+    }
+    fprintf(out, "\n");
+}
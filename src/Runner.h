@@ -0,0 +1,52 @@
+
+// Runs every replication of every parameter point of a study on a thread
+// pool, and summarizes each point across its replications with a mean and a
+// 95% confidence interval.  A point's row is written as soon as it and every
+// point before it have finished, so long studies report as they go.
+//
+// A study may branch: every replication then runs the first point up to the
+// branch time once, takes an in-memory snapshot and runs every point on from
+// it, so the points differ only in what happens after the branch.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+#include "Parameters.h"
+#include "Simulation.h"
+
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#define OUTPUT_TABLE 1 // tab-separated columns under a header line
+#define OUTPUT_CSV 2 // comma-separated columns under a header line
+#define OUTPUT_JSON 3 // one JSON object per line
+
+using namespace std;
+
+class Runner {
+    public:
+        Runner(const vector<Parameters>& points, int replications, uint64_t seed, const Snapshot* start = NULL);
+        void save(const char* path, double at) { _save_path = path; _save_at = at; } // save the only run when it reaches at
+        void branch(double at) { _branch_at = at; } // run every point on from the first point's run at at
+        void trace(const char* path) { _trace_path = path; } // trace the only run
+        void run(unsigned int num_threads, FILE* out, int output);
+    private:
+        void write_header(FILE* out, int output);
+        void write_row(FILE* out, int output, size_t point); // summary of a finished point
+        void finish(size_t p, int r, const Results& results, FILE* out, int output); // record a run, writing complete rows
+        vector<Parameters> _points;
+        int _replications;
+        uint64_t _seed;
+        const Snapshot* _start; // every run starts from it, if it is not NULL
+        const char* _save_path;
+        double _save_at;
+        double _branch_at; // negative for no branching
+        const char* _trace_path;
+        vector<int> _remaining; // replications of every point still running
+        size_t _next_row;
+        mutex _lock; // guards _remaining, _next_row and the output
+        vector<Results> _results; // indexed by point * replications + replication
+};
+
+#endif
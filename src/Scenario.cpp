@@ -0,0 +1,181 @@
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include "Scenario.h"
+#include "Runner.h"
+
+// strip leading and trailing white space
+static string trim(const string& s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+// parse a whole string as an integer from min to max, failing on trailing garbage
+static bool parse_integer(const string& value, long min, long max, long& number) {
+    char* end;
+    errno = 0;
+    number = strtol(value.c_str(), &end, 10);
+    return !value.empty() && *end == '\0' && errno == 0 && number >= min && number <= max;
+}
+
+// parse a whole string as a 64-bit seed, decimal or 0x hex, failing on trailing
+// garbage, overflow or a sign (strtoull would wrap a negative seed around)
+static bool parse_seed(const string& value, uint64_t& seed) {
+    char* end;
+    errno = 0;
+    unsigned long long number = strtoull(value.c_str(), &end, 0);
+    if (value.empty() || value.find('-') != string::npos || *end != '\0' || errno != 0) return false;
+    seed = number;
+    return true;
+}
+
+// split a list or range into its values; false if a range is malformed
+static bool expand_values(const string& value, vector<string>& values) {
+    size_t colon = value.find(':');
+    if (colon != string::npos) {
+        // from:to:step, to included
+        size_t colon2 = value.find(':', colon + 1);
+        if (colon2 == string::npos) return false;
+        char *end1, *end2, *end3;
+        string from_str = trim(value.substr(0, colon));
+        string to_str = trim(value.substr(colon + 1, colon2 - colon - 1));
+        string step_str = trim(value.substr(colon2 + 1));
+        double from = strtod(from_str.c_str(), &end1);
+        double to = strtod(to_str.c_str(), &end2);
+        double step = strtod(step_str.c_str(), &end3);
+        if (*end1 != '\0' || *end2 != '\0' || *end3 != '\0' || step <= 0 || to < from) return false;
+        for (int i = 0; from + i * step <= to + step * 1e-9; ++i) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.15g", from + i * step); // whole numbers without an exponent
+            values.push_back(buf);
+        }
+        return true;
+    }
+    size_t start = 0;
+    while (true) {
+        size_t comma = value.find(',', start);
+        values.push_back(trim(value.substr(start, comma == string::npos ? string::npos : comma - start)));
+        if (comma == string::npos) break;
+        start = comma + 1;
+    }
+    return true;
+}
+
+Scenario::Scenario() {
+    this->replications = 1;
+    this->seed = 0;
+    this->num_threads = thread::hardware_concurrency();
+    this->output = OUTPUT_TABLE;
+    this->snapshot_at = 0;
+    this->branch_at = -1;
+}
+
+bool Scenario::set(const string& name, const string& value) {
+    // run settings
+    long number;
+    if (name == "replications") {
+        if (!parse_integer(value, 1, INT_MAX, number)) return false;
+        this->replications = number;
+        return true;
+    } else if (name == "seed") {
+        return parse_seed(value, this->seed);
+    } else if (name == "threads") {
+        if (!parse_integer(value, 1, MAX_THREADS, number)) return false;
+        this->num_threads = number;
+        return true;
+    } else if (name == "output") {
+        if (value == "table") this->output = OUTPUT_TABLE;
+        else if (value == "csv") this->output = OUTPUT_CSV;
+        else if (value == "json") this->output = OUTPUT_JSON;
+        else return false;
+        return true;
+    } else if (name == "restore") {
+        this->restore = value;
+        return !value.empty();
+    } else if (name == "snapshot") {
+        this->snapshot = value;
+        return !value.empty();
+    } else if (name == "snapshot_at") {
+        char* end;
+        this->snapshot_at = strtod(value.c_str(), &end);
+        return *end == '\0' && this->snapshot_at >= 0;
+    } else if (name == "branch_at") {
+        char* end;
+        this->branch_at = strtod(value.c_str(), &end);
+        return *end == '\0' && this->branch_at >= 0;
+    } else if (name == "trace") {
+        this->trace = value;
+        return !value.empty();
+    }
+
+    // parameters: check every value before keeping them
+    vector<string> values;
+    if (!expand_values(value, values)) return false;
+    Parameters check;
+    for (vector<string>::iterator it = values.begin(); it != values.end(); ++it) {
+        if (!check.set(name, *it)) return false;
+    }
+    for (vector<pair<string, vector<string> > >::iterator it = this->_axes.begin(); it != this->_axes.end(); ++it) {
+        if (it->first == name) {
+            it->second = values; // a later setting replaces an earlier one
+            return true;
+        }
+    }
+    this->_axes.push_back(make_pair(name, values));
+    return true;
+}
+
+bool Scenario::load(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open scenario file '%s'\n", path);
+        return false;
+    }
+    char buf[4096];
+    int line_no = 0;
+    bool ok = true;
+    while (fgets(buf, sizeof(buf), fp) != NULL) {
+        ++line_no;
+        string line(buf);
+        size_t hash = line.find('#');
+        if (hash != string::npos) line = line.substr(0, hash);
+        line = trim(line);
+        if (line.empty()) continue;
+        size_t equals = line.find('=');
+        if (equals == string::npos) {
+            fprintf(stderr, "%s:%d: expected name = value\n", path, line_no);
+            ok = false;
+            continue;
+        }
+        string name = trim(line.substr(0, equals));
+        string value = trim(line.substr(equals + 1));
+        if (!this->set(name, value)) {
+            fprintf(stderr, "%s:%d: invalid setting '%s = %s'\n", path, line_no, name.c_str(), value.c_str());
+            ok = false;
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+vector<Parameters> Scenario::points() const {
+    vector<Parameters> points(1);
+    for (vector<pair<string, vector<string> > >::const_iterator it = this->_axes.begin(); it != this->_axes.end(); ++it) {
+        // every point so far is repeated once for each value of this axis
+        vector<Parameters> expanded;
+        for (vector<Parameters>::iterator p = points.begin(); p != points.end(); ++p) {
+            for (vector<string>::const_iterator v = it->second.begin(); v != it->second.end(); ++v) {
+                Parameters params = *p;
+                params.set(it->first, *v);
+                expanded.push_back(params);
+            }
+        }
+        points.swap(expanded);
+    }
+    return points;
+}
@@ -0,0 +1,48 @@
+
+// A study: the values of every parameter, the axes to sweep, how many
+// replications to run of every point and how to write the results.
+//
+// A scenario file holds one "name = value" setting per line, and "#" starts
+// a comment.  The names are those of Parameters plus the run settings
+// replications, seed, threads, output (table, csv or json), restore (a
+// snapshot file every run starts from), snapshot and snapshot_at (a file
+// to save the run to when it reaches that time), branch_at (when the
+// points branch off a run of the first point) and trace (a file to trace the
+// run to).  A parameter
+// given a comma-separated list of values, or a range "from:to:step" (to
+// included), is a sweep axis; the study runs every combination of the values
+// of its axes, the first axis varying slowest.
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Parameters.h"
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#define MAX_THREADS 1024 // worker threads a study may ask for
+
+using namespace std;
+
+class Scenario {
+    public:
+        Scenario();
+        bool load(const char* path); // read a scenario file, reporting errors to stderr
+        bool set(const string& name, const string& value); // false if the name or value is not valid
+        vector<Parameters> points() const; // every combination of the axis values
+        int replications;
+        uint64_t seed;
+        unsigned int num_threads;
+        int output; // OUTPUT_TABLE, OUTPUT_CSV or OUTPUT_JSON
+        string restore; // snapshot file every run starts from, or empty
+        string snapshot; // file to save the only run to, or empty
+        double snapshot_at; // when to save it
+        double branch_at; // when every point branches off the first point's run, or negative
+        string trace; // file to trace the only run to, or empty
+    private:
+        vector<pair<string, vector<string> > > _axes; // parameter values, in order of first setting
+};
+
+#endif
@@ -0,0 +1,634 @@
+
+#include <math.h>
+#include <algorithm>
+#include "Simulation.h"
+#include "SplitMix.h"
+#include "Topology.h"
+#include "blockchain-sim-defs.h"
+
+Simulation::Simulation(const Parameters& params, uint64_t seed, const Snapshot* start) : sl(), params(params) {
+    // initialize simlib
+    this->sl.event_list_kind = params.event_list_kind;
+    init_simlib(&this->sl);
+
+    // initialize model
+    this->_seed = seed;
+    this->_tracer = NULL;
+    if (start != NULL) this->restore_model(*start, seed);
+    else this->init_model(seed);
+}
+
+Simulation::~Simulation() {
+    delete this->_tracer; // writes out the last records
+    delete this->_propagation;
+    delete this->_network;
+    delete this->_pool;
+    for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+        delete *it;
+    }
+    delete this->_block_store;
+    delete this->_batches;
+    delete this->_tx_table;
+    free_simlib(&this->sl);
+}
+
+void Simulation::run(double until) {
+    struct event ev;
+    while (this->num_blocks < this->params.max_blocks && event_time(&this->sl) < until) {
+        // relay everything that happens before the next new transaction or block
+        this->advance(event_time(&this->sl));
+
+        // determine the next event
+        event_next(&this->sl, &ev);
+        ++this->num_events;
+        for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+            (*it)->sl.sim_time = this->sl.sim_time;
+        }
+
+        // invoke the appropriate event function
+        switch(ev.type) {
+            case EVENT_NEW_TRANSACTION:
+                this->new_transaction();
+                break;
+            case EVENT_NEW_BLOCK:
+                this->new_block();
+                break;
+        }
+
+        // file the relays it sent to other partitions
+        for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+            (*it)->deliver();
+        }
+        this->sample_levels();
+    }
+}
+
+void Simulation::sample_levels() {
+    // levels are only known between global events, when no partition is running
+    long mempool_txs = 0;
+    long events = this->sl.list_size[LIST_EVENT];
+    for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+        mempool_txs += (*it)->mempool_txs;
+        events += (*it)->sl.list_size[LIST_EVENT];
+    }
+    this->stats.mempool.set((double)mempool_txs / this->params.num_nodes, this->sl.sim_time);
+    this->stats.pending_events.set(events, this->sl.sim_time);
+}
+
+void Simulation::relay(const struct event& ev) {
+    // invoke the appropriate event function
+    switch(ev.type) {
+        case EVENT_TX_RELAY:
+            this->tx_relay(ev);
+            break;
+        case EVENT_BLOCK_RELAY:
+            this->block_relay(ev);
+            break;
+        case EVENT_TX_FLUSH:
+            this->_network->node(ev.id[0])->flush_transactions();
+            break;
+        case EVENT_TX_BATCH:
+            this->tx_batch(ev);
+            break;
+    }
+}
+
+void Simulation::advance(double until) {
+    if (this->params.engine == ENGINE_OPTIMISTIC && this->_partitions.size() > 1) {
+        this->advance_optimistic(until);
+        return;
+    }
+    if (this->_partitions.size() == 1) {
+        this->advance_partition(this->_partitions[0], until);
+        return;
+    }
+    while (true) {
+        // the window starts at the earliest pending relay event
+        double start = INFINITY;
+        for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+            start = min(start, event_time(&(*it)->sl));
+        }
+        if (start >= until) return;
+        double end = min(start + this->_lookahead, until);
+        if (end <= start) end = nextafter(start, INFINITY); // a lookahead below the clock's resolution
+
+        // run the window in every partition, then hand over the relays between partitions
+        for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+            Partition* partition = *it;
+            this->_pool->submit([this, partition, end]() { this->advance_partition(partition, end); });
+        }
+        this->_pool->wait();
+        for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+            Partition* partition = *it;
+            this->_pool->submit([this, partition]() { partition->deliver(); });
+        }
+        this->_pool->wait();
+    }
+}
+
+void Simulation::advance_partition(Partition* partition, double until) {
+    struct event ev;
+    while (event_time(&partition->sl) < until) {
+        event_next(&partition->sl, &ev);
+        ++partition->events;
+        this->relay(ev);
+    }
+}
+
+void Simulation::advance_optimistic(double until) {
+    while (true) {
+        // With no partition running, file every message in flight.  Rollbacks
+        // send anti-messages, so repeat until all inboxes stay empty.
+        bool received = true;
+        while (received) {
+            received = false;
+            for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+                if ((*it)->inbox.empty()) continue;
+                (*it)->receive();
+                received = true;
+            }
+        }
+
+        // No relay can now arrive earlier than the earliest pending one: that is
+        // the GVT, and nothing earlier will be rolled back.
+        double gvt = INFINITY;
+        for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+            gvt = min(gvt, event_time(&(*it)->sl));
+        }
+        for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+            (*it)->fossil_collect(min(gvt, until));
+        }
+        if (gvt >= until) return;
+
+        // let every partition run ahead for a while
+        for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+            Partition* partition = *it;
+            this->_pool->submit([this, partition, until]() { this->speculate(partition, until); });
+        }
+        this->_pool->wait();
+    }
+}
+
+void Simulation::speculate(Partition* partition, double until) {
+    struct event ev;
+    partition->logging = true;
+    for (int i = 0; i < SPECULATION_BATCH; ++i) {
+        partition->receive();
+        if (!partition->next(ev, until)) break;
+        ++partition->events;
+        this->relay(ev);
+    }
+    partition->logging = false;
+}
+
+void Simulation::init_model(uint64_t seed) {
+    // the nodes and their links
+    this->_network = new Network(this->params.num_nodes);
+
+    // blocks are shared by all nodes through the block store
+    this->_block_store = new BlockStore;
+
+    // transactions are stored once, in the tx table
+    this->_tx_table = new TxTable;
+    this->_batches = new BatchStore;
+
+    // initialize statistical variables and random number streams
+    this->num_blocks = 0;
+    this->num_transactions = 0;
+    this->num_confirmed = 0;
+    this->num_events = 0;
+
+    this->seed_streams(seed);
+
+    // every node starts in the first partition; see partition_network
+    unsigned int num_partitions = this->params.partitions;
+    for (unsigned int i = 0; i < num_partitions; ++i) {
+        this->_partitions.push_back(new Partition(i, num_partitions, &this->_partitions, &this->_owner,
+                                                  this->params.event_list_kind,
+                                                  this->params.engine == ENGINE_OPTIMISTIC && num_partitions > 1));
+    }
+    this->_owner.assign(this->params.num_nodes, 0);
+    this->_pool = num_partitions > 1 ? new ThreadPool(num_partitions) : NULL;
+
+    // add nodes to the network
+    unsigned int num_nodes = this->params.num_nodes;
+    unsigned int num_miners = this->params.miner_fraction * num_nodes;
+    for (unsigned int i = 0; i < num_nodes; ++i) {
+        this->_network->set_node(i, new Node(i, this->_network, this->_tx_table, this->_block_store, this->_batches,
+                                             &this->stats, this->_partitions[0], &this->params));
+        if (i < num_miners) {
+            this->_network->set_type(i, MINER);
+            // drawn even when miner_greediness is set, so the other draws stay the same
+            int greediness = (int)(lcgrand(&this->sl, STREAM_NODE_CHOICE) * 100) + 1;
+            this->_network->set_greediness(i, this->params.miner_greediness > 0 ? this->params.miner_greediness : greediness);
+        }
+        #ifdef DEBUG
+        printf("created %s node %d\n", i < num_miners ? "MINER" : "RELAY", i);
+        #endif
+    }
+
+    // add links between nodes based on min_links_per_node and mean_link_speed
+    uint64_t topology_seed = splitmix64(seed);
+    if (this->params.topology == TOPOLOGY_RANDOM) {
+        for (unsigned int node1 = 0; node1 < num_nodes; ++node1) {
+            while (this->_network->get_num_links(node1) < (unsigned int)this->params.min_links_per_node) { // if more links are needed
+                // find a node to link with
+                unsigned int node2 = this->random_node();
+                while (node1 == node2 || this->_network->linked(node1, node2)) {
+                    node2 = this->random_node();
+                }
+                #ifdef DEBUG
+                printf("linking node %d to node %d\n", node1, node2);
+                #endif
+                this->_network->add_link(node1, node2, expon(&this->sl, this->params.mean_link_speed, STREAM_LINK_SPEED));
+            }
+        }
+    } else {
+        build_topology(this->_network, this->params, topology_seed, this->_pool);
+    }
+    this->_network->pack();
+    this->_propagation = NULL;
+    if (this->params.propagation == PROPAGATION_ANALYTIC) this->_propagation = new Propagation(this->_network, this->_tx_table);
+
+    // split the network between the partitions
+    this->partition_network();
+
+    // schedule the first transaction and first block to occur
+    event_schedule(&this->sl, this->sl.sim_time + expon(&this->sl, this->params.mean_tx_interarrival, STREAM_TX_INTERARRIVAL), EVENT_NEW_TRANSACTION);
+    event_schedule(&this->sl, this->sl.sim_time + expon(&this->sl, this->params.mean_block_interarrival, STREAM_BLOCK_INTERARRIVAL), EVENT_NEW_BLOCK);
+}
+
+void Simulation::restore_model(const Snapshot& start, uint64_t seed) {
+    // the same objects as init_model makes, filled in from the snapshot
+    this->_network = new Network(this->params.num_nodes);
+    this->_block_store = new BlockStore;
+    this->_tx_table = new TxTable;
+    this->_batches = new BatchStore;
+    this->_propagation = NULL;
+    unsigned int num_partitions = this->params.partitions;
+    for (unsigned int i = 0; i < num_partitions; ++i) {
+        this->_partitions.push_back(new Partition(i, num_partitions, &this->_partitions, &this->_owner,
+                                                  this->params.event_list_kind, false));
+    }
+    this->_pool = num_partitions > 1 ? new ThreadPool(num_partitions) : NULL;
+
+    SnapshotReader in = start.state();
+    in.get_simlib(&this->sl);
+    this->num_blocks = in.get<int>();
+    this->num_transactions = in.get<int>();
+    this->num_confirmed = in.get<int>();
+    this->num_events = in.get<long>();
+    this->stats.restore(in);
+    this->_network->restore(in);
+    this->_tx_table->restore(in);
+    this->_block_store->restore(in);
+    this->_batches->restore(in);
+    in.get(this->_owner);
+    this->_lookahead = in.get<double>();
+    for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+        (*it)->restore(in);
+    }
+    for (unsigned int i = 0; i < this->params.num_nodes && in.ok(); ++i) {
+        if (this->_owner.size() != this->params.num_nodes || this->_owner[i] >= num_partitions) {
+            in.fail();
+            break;
+        }
+        Node* node = new Node(i, this->_network, this->_tx_table, this->_block_store, this->_batches, &this->stats,
+                              this->_partitions[this->_owner[i]], &this->params);
+        this->_network->set_node(i, node);
+        node->restore(in);
+    }
+    if (!in.ok() || in.remaining() != 0) {
+        fprintf(stderr, "The snapshot file is damaged\n");
+        exit(1);
+    }
+
+    // with another seed, the run goes its own way from here
+    if (seed != start.seed()) this->seed_streams(seed);
+    if (this->params.miner_greediness > 0) {
+        for (unsigned int i = 0; i < this->params.num_nodes; ++i) {
+            if (this->_network->get_type(i) == MINER) this->_network->set_greediness(i, this->params.miner_greediness);
+        }
+    }
+}
+
+bool Simulation::trace(const char* path) {
+    const char* problem = Tracer::cannot_trace(this->params);
+    if (problem != NULL) {
+        fprintf(stderr, "Cannot trace the run: %s\n", problem);
+        return false;
+    }
+    this->_tracer = new Tracer(this->_partitions.size());
+    if (!this->_tracer->open(path, this->params.num_nodes, this->_seed)) {
+        delete this->_tracer;
+        this->_tracer = NULL;
+        return false;
+    }
+    for (size_t i = 0; i < this->_partitions.size(); ++i) {
+        this->_partitions[i]->trace = this->_tracer->buffer(i);
+    }
+    return true;
+}
+
+bool Simulation::save(const char* path) {
+    SnapshotWriter out;
+    return this->save(out) && out.write(path);
+}
+
+Snapshot* Simulation::snapshot() {
+    SnapshotWriter out;
+    if (!this->save(out)) return NULL;
+    Snapshot* snapshot = new Snapshot;
+    snapshot->take(out);
+    return snapshot;
+}
+
+bool Simulation::save(SnapshotWriter& out) {
+    const char* problem = Snapshot::cannot_save(this->params);
+    if (problem != NULL) {
+        fprintf(stderr, "Cannot save a snapshot: %s\n", problem);
+        return false;
+    }
+    // in the order restore_model reads it
+    Snapshot::put_header(out, this->params, this->_seed);
+    out.put_simlib(&this->sl);
+    out.put(this->num_blocks);
+    out.put(this->num_transactions);
+    out.put(this->num_confirmed);
+    out.put(this->num_events);
+    this->stats.save(out);
+    this->_network->save(out);
+    this->_tx_table->save(out);
+    this->_block_store->save(out);
+    this->_batches->save(out);
+    out.put(this->_owner);
+    out.put(this->_lookahead);
+    for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+        (*it)->save(out);
+    }
+    for (unsigned int i = 0; i < this->params.num_nodes; ++i) {
+        this->_network->node(i)->save(out);
+    }
+    return true;
+}
+
+void Simulation::seed_streams(uint64_t& seed) {
+    // give every random number stream its own seed in [1, MODLUS - 1]
+    int streams[] = { STREAM_TX_INTERARRIVAL, STREAM_BLOCK_INTERARRIVAL, STREAM_LINK_SPEED, STREAM_NODE_CHOICE };
+    for (unsigned int i = 0; i < sizeof(streams) / sizeof(streams[0]); ++i) {
+        lcgrandst(&this->sl, (long)(splitmix64(seed) % 2147483646ULL) + 1, streams[i]);
+    }
+}
+
+unsigned int Simulation::random_node() {
+    // lcgrand is strictly less than 1, so this is always a valid index
+    return (unsigned int)(lcgrand(&this->sl, STREAM_NODE_CHOICE) * this->params.num_nodes);
+}
+
+void Simulation::new_transaction() {
+    ++this->num_transactions;
+
+    unsigned int random_index = this->random_node();
+
+    // the node should decide the tx fee, from the latest block to reach it
+    Node* node = this->_network->node(random_index);
+    Block* last_block = this->_propagation != NULL ? this->_propagation->last_block(random_index, this->sl.sim_time)
+                                                   : node->get_last_block();
+    float tx_fee = node->decide_tx_fee(last_block);
+
+    unsigned int tx_no = this->_tx_table->add(tx_fee, this->sl.sim_time);
+
+    #ifdef DEBUG
+    printf("new_transaction() %d from %d with fee %f at t=%f\n", tx_no, random_index, tx_fee, this->sl.sim_time);
+    #endif
+
+    // let the network know about the transaction
+    if (this->_propagation != NULL) this->_propagation->transaction(tx_no, random_index);
+    else node->broadcast_transaction(tx_no);
+
+    // schedule the next transaction
+    event_schedule(&this->sl, this->sl.sim_time + expon(&this->sl, this->params.mean_tx_interarrival, STREAM_TX_INTERARRIVAL), EVENT_NEW_TRANSACTION);
+}
+
+void Simulation::new_block() {
+    ++this->num_blocks;
+
+    unsigned int random_index = this->random_node();
+    while (this->_network->get_type(random_index) != MINER) {
+        random_index = this->random_node();
+    }
+
+    #ifdef DEBUG
+    printf("new_block() from %d\n", random_index);
+    #endif
+
+    double block_time = this->sl.sim_time;
+
+    int number_of_reward_changes = this->num_blocks / this->params.blocks_between_reward_changes;
+    float block_reward = this->params.default_block_reward / pow(2, number_of_reward_changes);
+
+    Node* miner = this->_network->node(random_index);
+    if (this->_propagation != NULL) this->_propagation->catch_up(miner, block_time);
+    vector<unsigned int>* tx_list = miner->decide_included_tx_list(block_reward, block_time);
+
+    // a tx is confirmed by the first block to include it
+    for (vector<unsigned int>::iterator it = tx_list->begin(); it != tx_list->end(); ++it) {
+        if (this->_tx_table->is_confirmed(*it)) continue;
+        this->_tx_table->set_confirmation_time(*it, block_time);
+        ++this->num_confirmed;
+    }
+
+    Block* b = new Block(this->num_blocks, tx_list, block_time, block_reward, this->_tx_table);
+    this->_block_store->add(b);
+    if (this->params.blocks_kept > 0) {
+        this->_block_store->prune(this->params.blocks_kept, this->params.num_nodes);
+        this->trim();
+    }
+
+    // let the network know about the block
+    if (this->_propagation != NULL) this->_propagation->mined(b, random_index);
+    else miner->broadcast_block(b);
+
+    // schedule the next block
+    event_schedule(&this->sl, this->sl.sim_time + expon(&this->sl, this->params.mean_block_interarrival, STREAM_BLOCK_INTERARRIVAL), EVENT_NEW_BLOCK);
+}
+
+void Simulation::trim() {
+    // A node only looks up a tx or block in its bitsets when it arrives, and
+    // it can only arrive if a relay of it is on its way.  The tx table is also
+    // asked about the txs in mempools, which miners put in blocks, and the txs
+    // of the block bodies that are kept.  New txs and blocks are numbered
+    // upwards, so nothing below the oldest of those is looked up again.
+    unsigned int tx_floor = this->_batches->oldest_tx(this->_tx_table->size());
+    unsigned int block_floor = this->num_blocks;
+    for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+        (*it)->oldest_relayed(tx_floor, block_floor);
+    }
+    for (unsigned int i = 0; i < this->params.num_nodes; ++i) {
+        tx_floor = this->_network->node(i)->oldest_relayed_tx(tx_floor);
+    }
+    unsigned int table_floor = this->_block_store->oldest_tx(tx_floor);
+    for (unsigned int i = 0; i < this->params.num_nodes; ++i) {
+        table_floor = this->_network->node(i)->oldest_pooled_tx(table_floor);
+        this->_network->node(i)->trim(tx_floor, block_floor);
+    }
+    this->_tx_table->trim(table_floor);
+}
+
+void Simulation::tx_relay(const struct event& ev) {
+    unsigned int tx_no = ev.id[0];
+    unsigned int node_no = ev.id[1];
+    #ifdef DEBUG
+    printf("tx_relay() of tx %d to node %d\n", tx_no, node_no);
+    #endif
+    this->_network->node(node_no)->broadcast_transaction(tx_no, ev.id[2]);
+}
+
+void Simulation::block_relay(const struct event& ev) {
+    unsigned int block_no = ev.id[0];
+    unsigned int from_node = ev.id[1];
+    unsigned int to_node = ev.id[2];
+    #ifdef DEBUG
+    printf("block_relay() of block %d from node %d to node %d\n", block_no, from_node, to_node);
+    #endif
+    this->_network->node(to_node)->broadcast_block(this->_block_store->get(block_no), from_node);
+}
+
+void Simulation::tx_batch(const struct event& ev) {
+    unsigned int to_node = ev.id[1];
+    vector<unsigned int> tx_nos;
+    this->_batches->take(ev.id[0], tx_nos);
+    for (vector<unsigned int>::iterator it = tx_nos.begin(); it != tx_nos.end(); ++it) {
+        this->_network->node(to_node)->broadcast_transaction(*it, ev.id[2]);
+    }
+}
+
+Results Simulation::results() {
+    Results r;
+    r.num_blocks = this->num_blocks;
+    r.num_transactions = this->num_transactions;
+    r.avg_ttc = this->stats.ttc.moments.mean();
+    r.avg_tx_fee = this->stats.tx_fee.moments.mean();
+    r.num_confirmed = this->num_confirmed;
+    r.num_pending = this->num_transactions - this->num_confirmed;
+    r.confirmed_fraction = this->num_transactions > 0 ? (float)this->num_confirmed / (float)this->num_transactions : 0;
+    // total eviction time across all nodes, per block
+    r.eviction_time = 0;
+    for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+        sampst(&(*it)->sl, 0.0, -SAMPST_EVICTION_TIME);
+        r.eviction_time += (*it)->sl.transfer[1] * (*it)->sl.transfer[2] / this->num_blocks;
+    }
+    r.events = this->num_events;
+    r.mempool_drops = 0;
+    for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+        r.events += (*it)->events;
+        r.mempool_drops += (*it)->mempool_drops;
+    }
+    this->sample_levels(); // close the last levels' intervals
+    r.mempool = this->stats.mempool.stat.moments.mean();
+    r.pending_events = this->stats.pending_events.stat.moments.mean();
+    r.stats = this->stats;
+    return r;
+}
+
+// one line with the mean, standard deviation and some quantiles of a statistic
+static void print_distribution(FILE* out, const char* name, const StreamStat& stat) {
+    fprintf(out, "%s mean/sd: %f/%f, p1/p50/p90/p99: %f/%f/%f/%f\n", name, stat.moments.mean(), stat.moments.sd(),
+            stat.digest.quantile(0.01), stat.digest.quantile(0.5), stat.digest.quantile(0.9), stat.digest.quantile(0.99));
+}
+
+void Simulation::report(FILE* out) {
+    Results r = this->results();
+    fprintf(out, "Number of blocks: %d\n", r.num_blocks);
+    fprintf(out, "Number of transactions: %d\n", r.num_transactions);
+    fprintf(out, "Confirmed transactions: %d\n", r.num_confirmed);
+    fprintf(out, "Pending transactions: %d\n", r.num_pending);
+    fprintf(out, "Avg time-to-confirmation: %f\n", r.avg_ttc);
+    fprintf(out, "Avg tx fee: %f\n", r.avg_tx_fee);
+    fprintf(out, "%% confirmed transactions: %f\n", r.confirmed_fraction);
+    fprintf(out, "Mempool eviction time per block (us): %f\n", r.eviction_time);
+    fprintf(out, "Events: %ld\n", r.events);
+    if (this->params.mempool_cap > 0) {
+        fprintf(out, "Mempool cap: %d txs, %ld txs dropped\n", this->params.mempool_cap, r.mempool_drops);
+    }
+    print_distribution(out, "Time-to-confirmation", r.stats.ttc);
+    print_distribution(out, "Tx fee", r.stats.tx_fee);
+    print_distribution(out, "Mempool size (txs per node, over time)", r.stats.mempool.stat);
+    print_distribution(out, "Pending events (over time)", r.stats.pending_events.stat);
+    // show how large simlib's memory pools grew in every partition
+    for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+        out_poolst(&(*it)->sl, out);
+    }
+    if (this->params.engine == ENGINE_OPTIMISTIC && this->_partitions.size() > 1) {
+        long rolled_back = 0;
+        for (vector<Partition*>::iterator it = this->_partitions.begin(); it != this->_partitions.end(); ++it) {
+            rolled_back += (*it)->rolled_back;
+        }
+        fprintf(out, "Relay events rolled back: %ld\n", rolled_back);
+    }
+    //TODO print rest of report
+}
+
+// find the root of node's cluster, halving the path on the way
+static unsigned int find_cluster(vector<unsigned int>& parent, unsigned int node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+void Simulation::partition_network() {
+    // The lookahead is the latency of the fastest link between partitions, so
+    // keep fast links inside partitions: like Kruskal's algorithm, take the
+    // links fastest first and merge the clusters at their ends unless the
+    // cluster would outgrow a partition.  Then deal the clusters, largest
+    // first, to the least loaded partition.
+    unsigned int num_nodes = this->_network->size();
+    unsigned int num_partitions = this->_partitions.size();
+    this->_lookahead = INFINITY;
+    if (num_partitions == 1) return;
+
+    vector<pair<float, pair<unsigned int, unsigned int> > > links;
+    for (unsigned int node = 0; node < num_nodes; ++node) {
+        for (unsigned int link = this->_network->links_begin(node); link != this->_network->links_end(node); ++link) {
+            unsigned int other = this->_network->neighbor(link);
+            if (node < other) links.push_back(make_pair(this->_network->speed(link), make_pair(node, other)));
+        }
+    }
+    sort(links.begin(), links.end());
+
+    unsigned int capacity = (num_nodes + num_partitions - 1) / num_partitions;
+    vector<unsigned int> parent(num_nodes), cluster_size(num_nodes, 1);
+    for (unsigned int i = 0; i < num_nodes; ++i) parent[i] = i;
+    for (size_t i = 0; i < links.size(); ++i) {
+        unsigned int a = find_cluster(parent, links[i].second.first);
+        unsigned int b = find_cluster(parent, links[i].second.second);
+        if (a == b || cluster_size[a] + cluster_size[b] > capacity) continue;
+        if (cluster_size[a] < cluster_size[b]) swap(a, b);
+        parent[b] = a;
+        cluster_size[a] += cluster_size[b];
+    }
+
+    vector<pair<unsigned int, unsigned int> > clusters; // (size, root), largest first
+    for (unsigned int i = 0; i < num_nodes; ++i) {
+        if (parent[i] == i) clusters.push_back(make_pair(cluster_size[i], i));
+    }
+    sort(clusters.begin(), clusters.end(), greater<pair<unsigned int, unsigned int> >());
+    vector<unsigned int> load(num_partitions, 0), cluster_partition(num_nodes);
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        unsigned int lightest = min_element(load.begin(), load.end()) - load.begin();
+        cluster_partition[clusters[i].second] = lightest;
+        load[lightest] += clusters[i].first;
+    }
+
+    for (unsigned int i = 0; i < num_nodes; ++i) {
+        this->_owner[i] = cluster_partition[find_cluster(parent, i)];
+        this->_network->node(i)->set_partition(this->_partitions[this->_owner[i]]);
+    }
+    for (size_t i = 0; i < links.size(); ++i) {
+        if (this->_owner[links[i].second.first] != this->_owner[links[i].second.second]) {
+            this->_lookahead = min(this->_lookahead, (double)links[i].first);
+        }
+    }
+}
@@ -0,0 +1,116 @@
+
+// One run of the simulation: its simlib context, its network of nodes, the
+// blocks and transactions created so far and its input parameters.  Runs
+// share no state, so several can coexist (or run side by side) in one
+// process.
+//
+// New transactions and blocks are global events: they are kept on sl and run
+// one at a time.  Relay events belong to the receiving node's partition.
+// Between two global events the partitions are advanced by a conservative
+// parallel engine in windows (YAWNS): a relay always takes at least the
+// lookahead, the latency of the fastest link between two partitions, so every
+// partition can safely run all of its events earlier than the window's start
+// plus the lookahead, side by side with the others.  Relays across partitions
+// wait in outboxes until the window ends.  When the lookahead is tiny, the
+// optimistic engine (Time Warp; see Partition.h) runs partitions ahead
+// instead, rolling back the few relays that turn out to be premature.  With
+// relay = gossip the results depend on neither the engine nor the number of
+// partitions.
+//
+// A run can be saved between two global events to a snapshot (see
+// Snapshot.h), and other runs can start from it.  A run that starts from a
+// snapshot with the seed of the saved run carries on exactly as the saved run
+// would have; with any other seed its random number streams are seeded again,
+// so replications started from one snapshot go their own ways.  A snapshot
+// can also be kept in memory, so that many branches of a run, each with its
+// own parameters, start from the same point without repeating what came
+// before it.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "Parameters.h"
+#include "Network.h"
+#include "Node.h"
+#include "BlockStore.h"
+#include "BatchStore.h"
+#include "TxTable.h"
+#include "Partition.h"
+#include "Propagation.h"
+#include "Snapshot.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
+#include "simlib.h"
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+using namespace std;
+
+// the outputs of a run, so far
+struct Results {
+    int num_blocks;
+    int num_transactions;
+    int num_confirmed; // txs included in at least one block
+    int num_pending; // txs not yet included in any block
+    double avg_ttc; // average time-to-confirmation
+    float avg_tx_fee;
+    float confirmed_fraction; // fraction of known transactions that were confirmed
+    float eviction_time; // wall-clock microseconds of mempool eviction per block, not reproducible
+    long events; // events run, including relay events that were rolled back and run again
+    float mempool; // txs in a node's mempool, on average over nodes and time
+    float pending_events; // on average over time
+    long mempool_drops; // txs dropped from full mempools
+    RunStats stats; // distributions, which can be merged with other runs'
+};
+
+class Simulation {
+    public:
+        Simulation(const Parameters& params, uint64_t seed, const Snapshot* start = NULL); // seed picks every random number stream
+        ~Simulation();
+        void run(double until = INFINITY); // run until params.max_blocks blocks are mined, or the next global event is at until or later
+        bool save(const char* path); // save a snapshot of the run, reporting errors to stderr
+        Snapshot* snapshot(); // the run as it is now, in memory, for branches to start from; NULL if it cannot be saved
+        bool trace(const char* path); // trace the rest of the run to a file (see Tracer.h), reporting errors to stderr
+        Results results(); // cheap, so it may be called at any point of the run
+        void report(FILE* out); // print statistics from the run
+        struct simlib sl;
+        Parameters params;
+        int num_blocks, num_transactions;
+        int num_confirmed; // txs included in at least one block, counted as blocks are mined
+        long num_events; // global events run
+        RunStats stats;
+    private:
+        void init_model(uint64_t seed); // initialize the model
+        void restore_model(const Snapshot& start, uint64_t seed); // initialize the model from a snapshot
+        bool save(SnapshotWriter& out); // append the run's state to out
+        void seed_streams(uint64_t& seed); // seed simlib's random number streams, advancing seed
+        void partition_network(); // assign nodes to partitions and find the lookahead
+        unsigned int random_node(); // pick a node uniformly at random
+        void new_transaction(); // run for every new transaction event
+        void new_block(); // run for every new block event
+        void trim(); // forget the txs and blocks that can no longer reach a node or go into a block, for long runs
+        void tx_relay(const struct event& ev); // run when transactions are relayed to nodes
+        void block_relay(const struct event& ev); // run when blocks are relayed to nodes
+        void tx_batch(const struct event& ev); // run when a batch of transactions is relayed to a node
+        void relay(const struct event& ev); // run a relay event
+        void advance(double until); // run every relay event earlier than until
+        void advance_partition(Partition* partition, double until); // run one partition's relay events earlier than until
+        void advance_optimistic(double until); // run every relay event earlier than until with Time Warp
+        void speculate(Partition* partition, double until); // run a batch of a partition's relay events optimistically
+        void sample_levels(); // record the mempool and event list levels now
+        Network* _network;
+        vector<Partition*> _partitions;
+        vector<unsigned int> _owner; // partition of every node
+        double _lookahead; // latency of the fastest link between two partitions
+        ThreadPool* _pool; // advances the partitions, if there is more than one
+        Propagation* _propagation; // with propagation = analytic, NULL otherwise
+        BlockStore* _block_store;
+        BatchStore* _batches;
+        TxTable* _tx_table;
+        Tracer* _tracer; // if the run is traced, NULL otherwise
+        uint64_t _seed;
+};
+
+#endif
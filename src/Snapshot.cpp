@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include "Parameters.h"
+#include "Snapshot.h"
+#include "simlib.h"
+
+static const char magic[FILE_MAGIC_SIZE] = { 'B', 'C', 'S', 'I', 'M', 'S', 'N', 'P' };
+
+// parameters that only shape what happens from now on, so a run may change
+// them when it starts from a snapshot; every other parameter shaped the saved
+// state and must match
+static const char* free_names[] = { "mean_tx_interarrival", "mean_block_interarrival", "max_blocks", "default_fee",
+                                    "default_block_reward", "blocks_between_reward_changes", "event_list",
+                                    "miner_greediness" };
+
+bool SnapshotWriter::write(const char* path) const {
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot create snapshot file '%s'\n", path);
+        return false;
+    }
+    bool ok = fwrite(this->_data.data(), 1, this->_data.size(), fp) == this->_data.size();
+    ok = fclose(fp) == 0 && ok;
+    if (!ok) fprintf(stderr, "Cannot write snapshot file '%s'\n", path);
+    return ok;
+}
+
+void SnapshotWriter::put_simlib(struct simlib* sl) {
+    size_t size = simlib_save(sl, NULL);
+    put((uint64_t)size);
+    this->_data.resize(this->_data.size() + size);
+    simlib_save(sl, &this->_data[this->_data.size() - size]);
+}
+
+void SnapshotReader::get_simlib(struct simlib* sl) {
+    size_t size = get_count(1);
+    const char* state = take(size);
+    if (state != NULL && (size == 0 || simlib_restore(sl, state, size) != size)) fail();
+}
+
+Snapshot::~Snapshot() {
+    delete this->_params;
+}
+
+void Snapshot::put_header(SnapshotWriter& out, const Parameters& params, uint64_t seed) {
+    for (size_t i = 0; i < sizeof(magic); ++i) out.put(magic[i]);
+    out.put((uint32_t)SNAPSHOT_VERSION);
+    out.put((uint32_t)FILE_BYTE_ORDER_MARK);
+    out.put(seed);
+    const vector<string>& names = Parameters::names();
+    out.put((uint32_t)names.size());
+    for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+        out.put(*it);
+        out.put(params.get(*it));
+    }
+}
+
+bool Snapshot::map(const char* path) {
+    if (!this->_file.map(path, "snapshot")) return false;
+    this->_data = this->_file.data();
+    this->_size = this->_file.size();
+    return this->read_header(path);
+}
+
+void Snapshot::take(SnapshotWriter& out) {
+    this->_taken.swap(out._data);
+    out._data.clear();
+    this->_data = this->_taken.data();
+    this->_size = this->_taken.size();
+    this->read_header("(in memory)");
+}
+
+bool Snapshot::read_header(const char* path) {
+    if (!MappedFile::check_header(this->_data, this->_size, magic, SNAPSHOT_VERSION, "snapshot", path)) return false;
+    SnapshotReader in(this->_data, this->_size);
+    in.take(FILE_HEADER_SIZE);
+    this->_seed = in.get<uint64_t>();
+    this->_params = new Parameters;
+    uint32_t num_params = in.get<uint32_t>();
+    for (uint32_t i = 0; i < num_params && in.ok(); ++i) {
+        string name = in.get_string();
+        string value = in.get_string();
+        if (!this->_params->set(name, value)) {
+            fprintf(stderr, "Snapshot file '%s' has an invalid parameter '%s = %s'\n", path, name.c_str(), value.c_str());
+            return false;
+        }
+    }
+    if (!in.ok()) {
+        fprintf(stderr, "Snapshot file '%s' is truncated\n", path);
+        return false;
+    }
+    this->_state = in.peek();
+    return true;
+}
+
+const char* Snapshot::cannot_save(const Parameters& params) {
+    // analytic propagation keeps its own state, and the optimistic engine's logs are not saved
+    if (params.propagation == PROPAGATION_ANALYTIC) return "snapshots need propagation = events";
+    if (params.partitions > 1 && params.engine == ENGINE_OPTIMISTIC) return "snapshots need the conservative engine";
+    return NULL;
+}
+
+const char* Snapshot::mismatch(const Parameters& saved, const Parameters& params) {
+    static string problem; // checked before any run starts, on one thread
+    const vector<string>& names = Parameters::names();
+    for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+        bool may_differ = false;
+        for (size_t i = 0; i < sizeof(free_names) / sizeof(free_names[0]); ++i) {
+            if (*it == free_names[i]) may_differ = true;
+        }
+        // gossip and trickle keep the same state, so a run may switch between them
+        if (*it == "relay") may_differ = saved.relay_policy != RELAY_PEEK && params.relay_policy != RELAY_PEEK;
+        if (!may_differ && params.get(*it) != saved.get(*it)) {
+            problem = *it + " must be " + saved.get(*it) + ", as in the snapshot";
+            return problem.c_str();
+        }
+    }
+    return NULL;
+}
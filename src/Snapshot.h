@@ -0,0 +1,132 @@
+
+// A snapshot is the whole state of a run between two global events, saved to
+// a binary file, so that other runs can start from a warmed-up network instead
+// of from time 0.  It holds the simlib contexts (clock, random number streams,
+// pending events and accumulators), the network, every node's mempool, blocks
+// and bitsets, the tx table, the block and batch stores and the streaming
+// statistics.
+//
+// The file starts with a magic string, the format version, a byte order mark,
+// the seed of the run and its parameters as name = value strings; the state
+// follows.  Values are written in the byte order of the machine, and a file
+// from another byte order or version is refused.  Snapshot maps the file
+// read-only, so any number of runs can start from one copy of it in memory.
+// A snapshot can also be taken from a running simulation without a file, for
+// the branches of a run.
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#define SNAPSHOT_VERSION 2
+
+using namespace std;
+
+struct simlib;
+struct Parameters;
+
+// appends values to a snapshot in memory
+class SnapshotWriter {
+    public:
+        template <class T> void put(const T& value) { // a value of a plain type
+            const char* bytes = (const char*)&value;
+            _data.insert(_data.end(), bytes, bytes + sizeof(T));
+        }
+        template <class T> void put(const vector<T>& values) { // its length, then its values
+            put((uint64_t)values.size());
+            const char* bytes = (const char*)values.data();
+            _data.insert(_data.end(), bytes, bytes + values.size() * sizeof(T));
+        }
+        void put(const string& s) {
+            put((uint64_t)s.size());
+            _data.insert(_data.end(), s.begin(), s.end());
+        }
+        void put_simlib(struct simlib* sl); // see simlib_save
+        bool write(const char* path) const; // write everything to a file, reporting errors to stderr
+    private:
+        vector<char> _data;
+
+        friend class Snapshot;
+};
+
+// reads values back from a snapshot in memory; past the end, every value is
+// zero and ok() is false
+class SnapshotReader {
+    public:
+        SnapshotReader(const char* data, size_t size) : _data(data), _size(size), _pos(0), _ok(true) {}
+        template <class T> T get() {
+            T value;
+            memset(&value, 0, sizeof(T));
+            const char* bytes = take(sizeof(T));
+            if (bytes != NULL) memcpy(&value, bytes, sizeof(T));
+            return value;
+        }
+        template <class T> void get(vector<T>& values) {
+            size_t size = get_count(sizeof(T));
+            const char* bytes = take(size * sizeof(T));
+            values.resize(size);
+            if (size > 0) memcpy(values.data(), bytes, size * sizeof(T));
+        }
+        string get_string() {
+            size_t size = get_count(1);
+            const char* bytes = take(size);
+            return bytes != NULL ? string(bytes, size) : string();
+        }
+        size_t get_count(size_t item_size) { // a count of items of at least item_size bytes that must follow
+            uint64_t count = get<uint64_t>();
+            if (count > remaining() / item_size) _ok = false;
+            return _ok ? count : 0;
+        }
+        const char* take(size_t size) { // the next size bytes, or NULL if there are not that many
+            if (!_ok || size > _size - _pos) {
+                _ok = false;
+                return NULL;
+            }
+            _pos += size;
+            return _data + _pos - size;
+        }
+        void get_simlib(struct simlib* sl); // into an initialized context with no pending events
+        const char* peek() const { return _data + _pos; } // the bytes not yet read
+        size_t remaining() const { return _size - _pos; }
+        bool ok() const { return _ok; }
+        void fail() { _ok = false; } // what was read does not make sense
+    private:
+        const char* _data;
+        size_t _size, _pos;
+        bool _ok;
+};
+
+// a snapshot file mapped into memory, or a snapshot taken in memory
+class Snapshot {
+    public:
+        Snapshot() : _data(NULL), _size(0), _state(NULL), _params(NULL), _seed(0) {}
+        ~Snapshot();
+        bool map(const char* path); // map a snapshot file and read its header, reporting errors to stderr
+        void take(SnapshotWriter& out); // take over what out holds, leaving it empty
+        static void put_header(SnapshotWriter& out, const Parameters& params, uint64_t seed);
+        static const char* cannot_save(const Parameters& params); // why a run with params cannot be saved, or NULL
+        const Parameters& params() const { return *_params; } // of the run that was saved
+        uint64_t seed() const { return _seed; } // of the run that was saved
+        const char* check(const Parameters& params) const { return mismatch(*_params, params); }
+        // why a run with params cannot start from a snapshot of a run with saved, or NULL
+        static const char* mismatch(const Parameters& saved, const Parameters& params);
+        SnapshotReader state() const { return SnapshotReader(_state, _data + _size - _state); }
+    private:
+        Snapshot(const Snapshot&); // not copied
+        bool read_header(const char* name); // reporting errors about name to stderr
+
+        MappedFile _file;
+        vector<char> _taken;
+        const char* _data; // in _file or _taken
+        size_t _size;
+        const char* _state; // after the header
+        Parameters* _params; // read from the header
+        uint64_t _seed;
+};
+
+#endif
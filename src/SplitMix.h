@@ -0,0 +1,30 @@
+
+// SplitMix64 (Steele, Lea and Flood): turns one 64-bit seed into a sequence of
+// well-mixed values, so nearby seeds still give unrelated values.  It seeds
+// simlib's streams, and it is the random number generator of work that is
+// split between threads, where a shared simlib stream would make the results
+// depend on the order the threads ran in.
+
+#include <math.h>
+#include <stdint.h>
+
+#ifndef SPLITMIX_H
+#define SPLITMIX_H
+
+static inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+struct SplitMix {
+    SplitMix(uint64_t seed) : state(seed) {}
+    uint64_t next() { return splitmix64(state); }
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); } // in [0, 1)
+    unsigned int below(unsigned int n) { return (unsigned int)(uniform() * n); } // in [0, n)
+    float expon(float mean) { return -mean * log(1.0 - uniform()); }
+    uint64_t state;
+};
+
+#endif
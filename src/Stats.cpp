@@ -0,0 +1,108 @@
+
+#include <algorithm>
+#include "Stats.h"
+
+void Welford::merge(const Welford& other) {
+    if (other._weight <= 0) return;
+    if (this->_weight <= 0) {
+        *this = other;
+        return;
+    }
+    // Chan et al.'s pairwise update
+    double weight = this->_weight + other._weight;
+    double delta = other._mean - this->_mean;
+    this->_mean += delta * other._weight / weight;
+    this->_m2 += other._m2 + delta * delta * this->_weight * other._weight / weight;
+    this->_weight = weight;
+    this->_count += other._count;
+    this->_min = std::min(this->_min, other._min);
+    this->_max = std::max(this->_max, other._max);
+}
+
+// the t-digest scale function k1: a centroid may span one unit of k, so
+// centroids are small where q is near 0 or 1
+static double scale(double q, double compression) {
+    return compression / (2 * M_PI) * asin(2 * q - 1);
+}
+
+void TDigest::compress() const {
+    if (this->_buffer.empty()) return;
+    vector<Centroid> all;
+    all.reserve(this->_centroids.size() + this->_buffer.size());
+    all.insert(all.end(), this->_centroids.begin(), this->_centroids.end());
+    all.insert(all.end(), this->_buffer.begin(), this->_buffer.end());
+    sort(all.begin(), all.end());
+    this->_buffer.clear();
+    this->_centroids.clear();
+
+    double total = 0;
+    for (vector<Centroid>::iterator it = all.begin(); it != all.end(); ++it) total += it->weight;
+
+    // sweep left to right, merging neighbors while the merged centroid spans at most one unit of k
+    Centroid current = all[0];
+    double before = 0; // weight left of current
+    double limit = scale(0, this->_compression) + 1;
+    for (size_t i = 1; i < all.size(); ++i) {
+        double q = (before + current.weight + all[i].weight) / total;
+        if (scale(q, this->_compression) <= limit) {
+            current.weight += all[i].weight;
+            current.mean += (all[i].mean - current.mean) * all[i].weight / current.weight;
+        } else {
+            this->_centroids.push_back(current);
+            before += current.weight;
+            limit = scale(before / total, this->_compression) + 1;
+            current = all[i];
+        }
+    }
+    this->_centroids.push_back(current);
+    this->_weight = total;
+}
+
+void TDigest::merge(const TDigest& other) {
+    other.compress();
+    this->_buffer.insert(this->_buffer.end(), other._centroids.begin(), other._centroids.end());
+    this->_min = std::min(this->_min, other._min);
+    this->_max = std::max(this->_max, other._max);
+    this->compress();
+}
+
+double TDigest::quantile(double q) const {
+    this->compress();
+    const vector<Centroid>& c = this->_centroids;
+    if (c.empty()) return NAN;
+    if (q <= 0) return this->_min;
+    if (q >= 1) return this->_max;
+    if (c.size() == 1) return c[0].mean;
+
+    // each centroid's mean is taken to sit at the middle of its weight;
+    // interpolate between neighboring middles (and the extremes at the ends)
+    double target = q * this->_weight;
+    double middle = c[0].weight / 2;
+    if (target < middle) return this->_min + (c[0].mean - this->_min) * target / middle;
+    for (size_t i = 1; i < c.size(); ++i) {
+        double next = middle + (c[i - 1].weight + c[i].weight) / 2;
+        if (target < next) return c[i - 1].mean + (c[i].mean - c[i - 1].mean) * (target - middle) / (next - middle);
+        middle = next;
+    }
+    double rest = this->_weight - middle;
+    return c.back().mean + (this->_max - c.back().mean) * (target - middle) / rest;
+}
+
+void TDigest::save(SnapshotWriter& out) const {
+    // the buffer is saved as it is: merging it now would change later quantiles
+    out.put(this->_compression);
+    out.put(this->_centroids);
+    out.put(this->_buffer);
+    out.put(this->_weight);
+    out.put(this->_min);
+    out.put(this->_max);
+}
+
+void TDigest::restore(SnapshotReader& in) {
+    this->_compression = in.get<double>();
+    in.get(this->_centroids);
+    in.get(this->_buffer);
+    this->_weight = in.get<double>();
+    this->_min = in.get<double>();
+    this->_max = in.get<double>();
+}
@@ -0,0 +1,162 @@
+
+// Streaming statistics that take constant memory however many observations
+// they are given, and that can be merged, so that the statistics of several
+// partitions, threads or replications can be pooled.
+//
+// Welford keeps the count, weighted mean and variance (by Welford's and
+// West's updates, in double precision) and the extremes.  TDigest is a
+// merging t-digest: observations are buffered, then merged into at most about
+// compression centroids, which are small near the tails, so quantiles are
+// most accurate where they are most often asked for (p1, p99).  StreamStat is
+// both.  LevelStat follows a level over time, like simlib's timest: every
+// level is weighted by how long it was held.
+
+#include <math.h>
+#include <vector>
+#include "Snapshot.h"
+
+#ifndef STATS_H
+#define STATS_H
+
+using namespace std;
+
+class Welford {
+    public:
+        Welford() : _count(0), _weight(0), _mean(0), _m2(0), _min(INFINITY), _max(-INFINITY) {}
+        void add(double x, double weight = 1) {
+            if (weight <= 0) return;
+            ++_count;
+            _weight += weight;
+            double delta = x - _mean;
+            _mean += delta * weight / _weight;
+            _m2 += weight * delta * (x - _mean);
+            if (x < _min) _min = x;
+            if (x > _max) _max = x;
+        }
+        void merge(const Welford& other);
+        long count() const { return _count; }
+        double mean() const { return _weight > 0 ? _mean : 0; }
+        double variance() const { return _weight > 0 ? _m2 / _weight : 0; } // of the weighted population
+        double sd() const { return sqrt(variance()); }
+        double min() const { return _min; }
+        double max() const { return _max; }
+        void save(SnapshotWriter& out) const {
+            out.put(_count);
+            out.put(_weight);
+            out.put(_mean);
+            out.put(_m2);
+            out.put(_min);
+            out.put(_max);
+        }
+        void restore(SnapshotReader& in) {
+            _count = in.get<long>();
+            _weight = in.get<double>();
+            _mean = in.get<double>();
+            _m2 = in.get<double>();
+            _min = in.get<double>();
+            _max = in.get<double>();
+        }
+    private:
+        long _count;
+        double _weight, _mean, _m2, _min, _max;
+};
+
+class TDigest {
+    public:
+        TDigest(double compression = 200) : _compression(compression), _weight(0), _min(INFINITY), _max(-INFINITY) {}
+        void add(double x, double weight = 1) {
+            if (weight <= 0) return;
+            _buffer.push_back(Centroid { x, weight });
+            if (x < _min) _min = x;
+            if (x > _max) _max = x;
+            if (_buffer.size() >= 4 * _compression) compress();
+        }
+        void merge(const TDigest& other);
+        double quantile(double q) const; // NAN if nothing was added
+        void save(SnapshotWriter& out) const;
+        void restore(SnapshotReader& in);
+    private:
+        struct Centroid {
+            double mean, weight;
+            bool operator<(const Centroid& other) const { return mean < other.mean; }
+        };
+        void compress() const; // merge the buffer into the centroids
+        double _compression;
+        mutable vector<Centroid> _centroids; // sorted by mean
+        mutable vector<Centroid> _buffer; // added since the last compress
+        mutable double _weight; // of the centroids
+        double _min, _max;
+};
+
+class StreamStat {
+    public:
+        void add(double x, double weight = 1) {
+            moments.add(x, weight);
+            digest.add(x, weight);
+        }
+        void merge(const StreamStat& other) {
+            moments.merge(other.moments);
+            digest.merge(other.digest);
+        }
+        void save(SnapshotWriter& out) const {
+            moments.save(out);
+            digest.save(out);
+        }
+        void restore(SnapshotReader& in) {
+            moments.restore(in);
+            digest.restore(in);
+        }
+        Welford moments;
+        TDigest digest;
+};
+
+class LevelStat {
+    public:
+        LevelStat() : _level(0), _since(0) {}
+        void set(double level, double now) { // the level changes to level at time now
+            stat.add(_level, now - _since);
+            _level = level;
+            _since = now;
+        }
+        void save(SnapshotWriter& out) const {
+            stat.save(out);
+            out.put(_level);
+            out.put(_since);
+        }
+        void restore(SnapshotReader& in) {
+            stat.restore(in);
+            _level = in.get<double>();
+            _since = in.get<double>();
+        }
+        StreamStat stat; // of the levels, weighted by how long each was held
+    private:
+        double _level, _since;
+};
+
+// the streaming statistics of one run
+struct RunStats {
+    void merge(const RunStats& other) {
+        ttc.merge(other.ttc);
+        tx_fee.merge(other.tx_fee);
+        mempool.stat.merge(other.mempool.stat);
+        pending_events.stat.merge(other.pending_events.stat);
+    }
+    void save(SnapshotWriter& out) const {
+        ttc.save(out);
+        tx_fee.save(out);
+        mempool.save(out);
+        pending_events.save(out);
+    }
+    void restore(SnapshotReader& in) {
+        ttc.restore(in);
+        tx_fee.restore(in);
+        mempool.restore(in);
+        pending_events.restore(in);
+    }
+    StreamStat ttc; // time-to-confirmation of every tx in every block
+    StreamStat tx_fee; // fee of every new tx
+    LevelStat mempool; // txs in a node's mempool, on average over nodes
+    LevelStat pending_events; // pending events, in every partition and the global list
+};
+
+#endif
@@ -0,0 +1,95 @@
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int num_threads) {
+    this->_queued = 0;
+    this->_pending = 0;
+    this->_next_queue = 0;
+    this->_stop = false;
+    if (num_threads == 0) num_threads = 1;
+    for (unsigned int i = 0; i < num_threads; ++i) {
+        this->_queues.push_back(new WorkQueue);
+    }
+    for (unsigned int i = 0; i < num_threads; ++i) {
+        this->_workers.push_back(thread(&ThreadPool::work, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    this->wait();
+    {
+        lock_guard<mutex> guard(this->_lock);
+        this->_stop = true;
+    }
+    this->_work_ready.notify_all();
+    for (vector<thread>::iterator it = this->_workers.begin(); it != this->_workers.end(); ++it) {
+        it->join();
+    }
+    for (vector<WorkQueue*>::iterator it = this->_queues.begin(); it != this->_queues.end(); ++it) {
+        delete *it;
+    }
+}
+
+void ThreadPool::submit(function<void()> task) {
+    // counted before it is queued, so a worker cannot finish it before it is counted
+    {
+        lock_guard<mutex> guard(this->_lock);
+        ++this->_queued;
+        ++this->_pending;
+    }
+    WorkQueue* queue = this->_queues[this->_next_queue++ % this->_queues.size()];
+    {
+        lock_guard<mutex> guard(queue->lock);
+        queue->tasks.push_back(task);
+    }
+    this->_work_ready.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(this->_lock);
+    while (this->_pending > 0) this->_all_done.wait(guard);
+}
+
+bool ThreadPool::take(unsigned int self, function<void()>& task) {
+    // oldest task from our own deque, so results come back in submission order
+    WorkQueue* own = this->_queues[self];
+    {
+        lock_guard<mutex> guard(own->lock);
+        if (!own->tasks.empty()) {
+            task = own->tasks.front();
+            own->tasks.pop_front();
+            return true;
+        }
+    }
+    // otherwise the oldest task of another worker
+    for (unsigned int i = 1; i < this->_queues.size(); ++i) {
+        WorkQueue* victim = this->_queues[(self + i) % this->_queues.size()];
+        lock_guard<mutex> guard(victim->lock);
+        if (!victim->tasks.empty()) {
+            task = victim->tasks.front();
+            victim->tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::work(unsigned int self) {
+    function<void()> task;
+    while (true) {
+        if (this->take(self, task)) {
+            {
+                lock_guard<mutex> guard(this->_lock);
+                --this->_queued;
+            }
+            task();
+            lock_guard<mutex> guard(this->_lock);
+            if (--this->_pending == 0) this->_all_done.notify_all();
+            continue;
+        }
+        // nothing to take: sleep until more work is submitted
+        unique_lock<mutex> guard(this->_lock);
+        while (this->_queued == 0 && !this->_stop) this->_work_ready.wait(guard);
+        if (this->_stop && this->_queued == 0) return;
+    }
+}
@@ -0,0 +1,47 @@
+
+// A fixed set of worker threads that run submitted tasks.  Every worker has
+// its own deque: submitted tasks are dealt out round-robin, a worker takes
+// the oldest task of its own deque and, when that is empty, steals the oldest
+// task of another, so uneven task lengths still keep every core busy and
+// tasks start roughly in the order they were submitted.  Tasks may submit
+// more tasks, which wait() also waits for.
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+using namespace std;
+
+class ThreadPool {
+    public:
+        ThreadPool(unsigned int num_threads);
+        ~ThreadPool(); // finishes the submitted tasks, then stops the workers
+        unsigned int size() const { return _workers.size(); }
+        void submit(function<void()> task);
+        void wait(); // block until every submitted task has finished
+    private:
+        struct WorkQueue {
+            mutex lock;
+            deque<function<void()> > tasks;
+        };
+        void work(unsigned int self); // worker thread body
+        bool take(unsigned int self, function<void()>& task); // own deque first, then steal
+        vector<WorkQueue*> _queues; // one per worker
+        vector<thread> _workers;
+        mutex _lock; // guards the counters below
+        condition_variable _work_ready, _all_done;
+        size_t _queued; // tasks waiting in some deque
+        size_t _pending; // tasks submitted but not yet finished
+        atomic<unsigned int> _next_queue; // round-robin, by any thread that submits
+        bool _stop;
+};
+
+#endif
@@ -0,0 +1,107 @@
+
+#include <algorithm>
+#include <vector>
+#include "Topology.h"
+#include "SplitMix.h"
+
+#define TOPOLOGY_CHUNK 65536 // nodes per chunk of a generator that runs side by side
+
+struct Edge {
+    unsigned int node1, node2;
+    float speed;
+};
+
+static void regular(const Parameters& params, unsigned int num_nodes, SplitMix& rng, vector<Edge>& edges) {
+    unsigned int k = params.min_links_per_node;
+    vector<unsigned int> ends((size_t)num_nodes * k);
+    for (size_t i = 0; i < ends.size(); ++i) ends[i] = i / k;
+    for (size_t i = ends.size(); i > 1; --i) swap(ends[i - 1], ends[rng.below(i)]);
+    for (size_t i = 0; i + 1 < ends.size(); i += 2) {
+        Edge e = { ends[i], ends[i + 1], rng.expon(params.mean_link_speed) };
+        edges.push_back(e);
+    }
+}
+
+static void scale_free(const Parameters& params, unsigned int num_nodes, SplitMix& rng, vector<Edge>& edges) {
+    // a link's far end is a copy of a random earlier link end, so nodes are
+    // picked in proportion to their links so far
+    unsigned int k = params.min_links_per_node;
+    vector<unsigned int> ends(2 * (size_t)num_nodes * k);
+    for (unsigned int v = 0; v < num_nodes; ++v) {
+        for (unsigned int i = 0; i < k; ++i) {
+            size_t end = 2 * ((size_t)v * k + i);
+            ends[end] = v;
+            ends[end + 1] = ends[rng.below(end + 1)];
+            Edge e = { v, ends[end + 1], rng.expon(params.mean_link_speed) };
+            edges.push_back(e);
+        }
+    }
+}
+
+static void small_world(const Parameters& params, unsigned int num_nodes, unsigned int first, unsigned int last,
+                        SplitMix& rng, vector<Edge>& edges) {
+    unsigned int half = (params.min_links_per_node + 1) / 2; // links to the following nodes on the ring
+    for (unsigned int v = first; v < last; ++v) {
+        for (unsigned int j = 1; j <= half; ++j) {
+            unsigned int other = (v + j) % num_nodes;
+            if (rng.uniform() < params.rewire_probability) other = rng.below(num_nodes);
+            Edge e = { v, other, rng.expon(params.mean_link_speed) };
+            edges.push_back(e);
+        }
+    }
+}
+
+static void geographic(const Parameters& params, unsigned int num_nodes, unsigned int first, unsigned int last,
+                       SplitMix& rng, vector<Edge>& edges) {
+    // node v is in region v % regions, so miners are spread over every region
+    unsigned int regions = params.regions;
+    unsigned int peers = (params.min_links_per_node + 1) / 2;
+    for (unsigned int v = first; v < last; ++v) {
+        for (unsigned int j = 0; j < peers; ++j) {
+            unsigned int other = rng.below(num_nodes);
+            unsigned int apart = (v % regions > other % regions) ? v % regions - other % regions
+                                                                  : other % regions - v % regions;
+            apart = min(apart, regions - apart);
+            Edge e = { v, other, rng.expon(params.mean_link_speed) * (1 + apart) };
+            edges.push_back(e);
+        }
+    }
+}
+
+void build_topology(Network* network, const Parameters& params, uint64_t seed, ThreadPool* pool) {
+    unsigned int num_nodes = network->size();
+    vector<vector<Edge> > chunks;
+    if (params.topology == TOPOLOGY_REGULAR || params.topology == TOPOLOGY_SCALE_FREE) {
+        // a single sweep over all nodes
+        chunks.resize(1);
+        SplitMix rng(seed);
+        if (params.topology == TOPOLOGY_REGULAR) regular(params, num_nodes, rng, chunks[0]);
+        else scale_free(params, num_nodes, rng, chunks[0]);
+    } else {
+        chunks.resize((num_nodes + TOPOLOGY_CHUNK - 1) / TOPOLOGY_CHUNK);
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            vector<Edge>* edges = &chunks[c];
+            function<void()> task = [&params, num_nodes, seed, c, edges]() {
+                uint64_t state = seed + c;
+                SplitMix rng(splitmix64(state));
+                unsigned int first = c * TOPOLOGY_CHUNK;
+                unsigned int last = min((size_t)num_nodes, (c + 1) * (size_t)TOPOLOGY_CHUNK);
+                if (params.topology == TOPOLOGY_SMALL_WORLD) small_world(params, num_nodes, first, last, rng, *edges);
+                else geographic(params, num_nodes, first, last, rng, *edges);
+            };
+            if (pool != NULL) pool->submit(task);
+            else task();
+        }
+        if (pool != NULL) pool->wait();
+    }
+
+    // add the links in chunk order, dropping loops and repeats
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        for (vector<Edge>::iterator e = chunks[c].begin(); e != chunks[c].end(); ++e) {
+            if (e->node1 != e->node2 && !network->linked(e->node1, e->node2)) {
+                network->add_link(e->node1, e->node2, e->speed);
+            }
+        }
+        vector<Edge>().swap(chunks[c]);
+    }
+}
@@ -0,0 +1,34 @@
+
+// Generators of the network's links, other than the original random one (in
+// Simulation::init_model), selected by the topology parameter.  Each makes
+// O(E) links with min_links_per_node as its degree parameter k:
+//
+//   regular      every node has k links (configuration model: k link ends per
+//                node, shuffled and paired)
+//   scale_free   Barabasi-Albert preferential attachment: every node links to
+//                k earlier nodes picked in proportion to their links
+//                (Batagelj and Brandes' list of link ends)
+//   small_world  Watts-Strogatz: a ring where every node links to the k
+//                nearest, each link rewired to a random node with probability
+//                rewire_probability
+//   geographic   every node links to k/2 random peers; the nodes are spread
+//                over regions around a ring, and a link's latency grows with
+//                the number of regions between its ends
+//
+// Links that would join a node to itself or repeat a link are dropped, so
+// degrees can fall a little short of k.  Small-world and geographic links
+// are made in fixed-size chunks of nodes, side by side on the run's thread
+// pool; every chunk has its own SplitMix stream, seeded from the run's seed,
+// so the links do not depend on the number of threads.
+
+#include <stdint.h>
+#include "Network.h"
+#include "Parameters.h"
+#include "ThreadPool.h"
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+void build_topology(Network* network, const Parameters& params, uint64_t seed, ThreadPool* pool); // pool may be NULL
+
+#endif
@@ -0,0 +1,138 @@
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "Parameters.h"
+#include "Tracer.h"
+
+static const char magic[FILE_MAGIC_SIZE] = { 'B', 'C', 'S', 'I', 'M', 'T', 'R', 'C' };
+
+struct TraceHeader {
+    char magic[FILE_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t record_size;
+    uint32_t num_nodes;
+    uint64_t seed;
+};
+
+size_t TraceBuffer::drain(FILE* fp) {
+    size_t tail = this->_tail.load(memory_order_relaxed);
+    size_t head = this->_head.load(memory_order_acquire);
+    // the records may wrap around the end of the ring
+    for (size_t pos = tail; pos < head; ) {
+        size_t start = pos & (TRACE_BUFFER_SIZE - 1);
+        size_t count = min(head - pos, (size_t)TRACE_BUFFER_SIZE - start);
+        fwrite(&this->_records[start], sizeof(TraceRecord), count, fp);
+        pos += count;
+    }
+    this->_tail.store(head, memory_order_release);
+    return head - tail;
+}
+
+Tracer::Tracer(unsigned int num_buffers) : _fp(NULL), _path(NULL), _stop(false) {
+    for (unsigned int i = 0; i < num_buffers; ++i) {
+        this->_buffers.push_back(new TraceBuffer(&this->_wake));
+    }
+}
+
+Tracer::~Tracer() {
+    if (this->_fp != NULL) {
+        this->_stop = true;
+        this->_wake.notify_one();
+        this->_writer.join();
+        bool ok = !ferror(this->_fp);
+        ok = fclose(this->_fp) == 0 && ok;
+        if (!ok) fprintf(stderr, "Cannot write trace file '%s'\n", this->_path);
+    }
+    for (vector<TraceBuffer*>::iterator it = this->_buffers.begin(); it != this->_buffers.end(); ++it) {
+        delete *it;
+    }
+}
+
+bool Tracer::open(const char* path, unsigned int num_nodes, uint64_t seed) {
+    this->_fp = fopen(path, "wb");
+    if (this->_fp == NULL) {
+        fprintf(stderr, "Cannot create trace file '%s'\n", path);
+        return false;
+    }
+    this->_path = path;
+    setvbuf(this->_fp, NULL, _IOFBF, 1 << 20);
+    TraceHeader header;
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = TRACE_VERSION;
+    header.byte_order_mark = FILE_BYTE_ORDER_MARK;
+    header.record_size = sizeof(TraceRecord);
+    header.num_nodes = num_nodes;
+    header.seed = seed;
+    fwrite(&header, sizeof(header), 1, this->_fp);
+    this->_writer = thread(&Tracer::drain, this);
+    return true;
+}
+
+void Tracer::drain() {
+    while (true) {
+        // read the flag first, so nothing put before it was set is left behind
+        bool stop = this->_stop;
+        size_t drained = 0;
+        for (vector<TraceBuffer*>::iterator it = this->_buffers.begin(); it != this->_buffers.end(); ++it) {
+            drained += (*it)->drain(this->_fp);
+        }
+        if (stop) return;
+        if (drained == 0) {
+            // a wakeup may be missed while we drain, so sleep for a while at most
+            unique_lock<mutex> guard(this->_lock);
+            this->_wake.wait_for(guard, chrono::milliseconds(1));
+        }
+    }
+}
+
+const char* Tracer::cannot_trace(const Parameters& params) {
+    // analytic propagation has no arrival events, and the optimistic engine may undo the ones it ran
+    if (params.propagation == PROPAGATION_ANALYTIC) return "tracing needs propagation = events";
+    if (params.partitions > 1 && params.engine == ENGINE_OPTIMISTIC) return "tracing needs the conservative engine";
+    return NULL;
+}
+
+bool TraceFile::map(const char* path) {
+    if (!this->_file.map(path, "trace")) return false;
+    const char* data = this->_file.data();
+    size_t size = this->_file.size();
+    if (!MappedFile::check_header(data, size, magic, TRACE_VERSION, "trace", path)) return false;
+    const TraceHeader* header = (const TraceHeader*)data;
+    if (size < sizeof(TraceHeader) || header->record_size != sizeof(TraceRecord)) {
+        fprintf(stderr, "The trace file '%s' has records that this program cannot read\n", path);
+        return false;
+    }
+    this->_num_nodes = header->num_nodes;
+    this->_seed = header->seed;
+    this->_records = (const TraceRecord*)(data + sizeof(TraceHeader));
+    // a run that was cut short may leave part of a record at the end
+    this->_num_records = (size - sizeof(TraceHeader)) / sizeof(TraceRecord);
+    for (size_t i = 0; i < this->_num_records; ++i) {
+        if (!this->valid(this->_records[i])) {
+            fprintf(stderr, "The trace file '%s' is damaged at record %zu\n", path, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TraceFile::valid(const TraceRecord& r) const {
+    if (!(r.time >= 0 && r.time <= DBL_MAX) || r.kind < TRACE_NEW_TX || r.kind > TRACE_BLOCK_COPY) return false;
+    if (r.to_node < 0 || (uint32_t)r.to_node >= this->_num_nodes) return false;
+    // a tx or block is created at a node, and reaches it from another one
+    if (r.kind == TRACE_NEW_TX || r.kind == TRACE_NEW_BLOCK) return r.from_node == -1;
+    return r.from_node >= 0 && (uint32_t)r.from_node < this->_num_nodes;
+}
+
+static bool earlier(const TraceRecord* a, const TraceRecord* b) {
+    return a->time < b->time;
+}
+
+void TraceFile::sorted(vector<const TraceRecord*>& out) const {
+    out.resize(this->_num_records);
+    for (size_t i = 0; i < this->_num_records; ++i) out[i] = &this->_records[i];
+    // stable, so a partition's records at the same time keep the order they ran in
+    stable_sort(out.begin(), out.end(), earlier);
+}
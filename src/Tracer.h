@@ -0,0 +1,123 @@
+// A binary trace of a run: one fixed-width record for every transaction and
+// block that is created or that reaches a node, so propagation can be studied
+// (and the run read back event by event) after it ends.  Tracing is switched
+// on at run time and costs one branch per arrival when it is off.
+//
+// Every partition writes its records into its own ring buffer, which has a
+// single writer (whichever thread is running the partition, or the main
+// thread between windows) and a single reader: a background thread that
+// drains every buffer to the trace file.  The writer wakes the background
+// thread whenever half of its buffer has filled up, and a full buffer makes it
+// wait for the background thread, so no record is lost.  Records of different
+// partitions are interleaved in the file; TraceFile readers sort them by time.
+//
+// The file starts with a magic string, the format version, a byte order
+// mark, the record size, the number of nodes and the seed of the run; the
+// records follow, in the byte order of the machine.  See blockchain-trace.cpp
+// for the tool that reads it.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MappedFile.h"
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#define TRACE_VERSION 1
+#define TRACE_BUFFER_SIZE 16384 // records in a partition's ring buffer, a power of 2
+
+using namespace std;
+
+struct Parameters;
+
+// kinds of trace records
+enum TraceKind { TRACE_NEW_TX = 1, TRACE_NEW_BLOCK, TRACE_TX_ARRIVAL, TRACE_BLOCK_ARRIVAL, TRACE_TX_COPY,
+                 TRACE_BLOCK_COPY };
+
+// a tx or block created at node to_node (from_node is -1), or reaching node
+// to_node from node from_node; a copy is one the node had already seen
+struct TraceRecord {
+    double time;
+    uint32_t kind; // TRACE_*
+    uint32_t no; // tx or block number
+    int32_t from_node;
+    int32_t to_node;
+};
+
+// a ring buffer of records with one writer and one reader
+class TraceBuffer {
+    public:
+        TraceBuffer(condition_variable* wake) : _head(0), _free_until(TRACE_BUFFER_SIZE), _wake(wake), _tail(0) {}
+        void put(int kind, double time, unsigned int no, int from_node, int to_node) { // writer only
+            size_t head = _head.load(memory_order_relaxed);
+            if (head == _free_until) {
+                // the reader's position is only looked at when the room seen last time is used up
+                while ((_free_until = _tail.load(memory_order_acquire) + TRACE_BUFFER_SIZE) == head) {
+                    _wake->notify_one();
+                    this_thread::yield();
+                }
+            }
+            TraceRecord& record = _records[head & (TRACE_BUFFER_SIZE - 1)];
+            record.time = time;
+            record.kind = kind;
+            record.no = no;
+            record.from_node = from_node;
+            record.to_node = to_node;
+            _head.store(head + 1, memory_order_release);
+            if (((head + 1) & (TRACE_BUFFER_SIZE / 2 - 1)) == 0) _wake->notify_one();
+        }
+        size_t drain(FILE* fp); // write every record put so far to fp; reader only
+    private:
+        TraceRecord _records[TRACE_BUFFER_SIZE];
+        atomic<size_t> _head; // records put
+        size_t _free_until; // the writer may put records until _head gets here
+        condition_variable* _wake; // of the background thread
+        char _pad[64]; // keeps the writer's and the reader's counters on their own cache lines
+        atomic<size_t> _tail; // records drained
+};
+
+// writes the records of a run's partitions to a trace file
+class Tracer {
+    public:
+        Tracer(unsigned int num_buffers);
+        ~Tracer(); // drains what is left and closes the file
+        bool open(const char* path, unsigned int num_nodes, uint64_t seed); // reporting errors to stderr
+        TraceBuffer* buffer(unsigned int i) { return _buffers[i]; }
+        static const char* cannot_trace(const Parameters& params); // why a run with params cannot be traced, or NULL
+    private:
+        void drain(); // background thread body
+        vector<TraceBuffer*> _buffers;
+        FILE* _fp;
+        const char* _path;
+        thread _writer;
+        mutex _lock; // for _wake
+        condition_variable _wake; // the background thread has work
+        atomic<bool> _stop;
+};
+
+// a trace file mapped into memory
+class TraceFile {
+    public:
+        TraceFile() : _records(NULL), _num_records(0), _num_nodes(0), _seed(0) {}
+        // map a trace file, read its header and check its records, reporting errors to stderr
+        bool map(const char* path);
+        const TraceRecord* records() const { return _records; } // in the order they were written
+        size_t num_records() const { return _num_records; }
+        unsigned int num_nodes() const { return _num_nodes; }
+        uint64_t seed() const { return _seed; }
+        void sorted(vector<const TraceRecord*>& out) const; // every record, by time
+    private:
+        bool valid(const TraceRecord& r) const; // whether r has a known kind and nodes of the run
+        MappedFile _file;
+        const TraceRecord* _records;
+        size_t _num_records;
+        unsigned int _num_nodes;
+        uint64_t _seed;
+};
+
+#endif
@@ -0,0 +1,60 @@
+
+// Every transaction created during a run, stored once as columns indexed by
+// tx number.  Nodes and blocks refer to transactions by their 32-bit tx
+// number rather than holding copies, and scans over fees or times touch one
+// contiguous array.  For long runs, the txs below a number that no node can
+// still receive, hold in its mempool or find in a kept block body can be
+// trimmed, so the table only holds the recent ones.
+
+#include <algorithm>
+#include <vector>
+#include "Snapshot.h"
+
+#ifndef TXTABLE_H
+#define TXTABLE_H
+
+using namespace std;
+
+class TxTable {
+    public:
+        TxTable() : _base(0) {}
+        unsigned int add(float tx_fee, double broadcast_time) { // returns the new tx number
+            _tx_fee.push_back(tx_fee);
+            _broadcast_time.push_back(broadcast_time);
+            _confirmation_time.push_back(-1);
+            return size() - 1;
+        }
+        unsigned int size() const { return _base + _tx_fee.size(); } // txs created, including trimmed ones
+        float get_tx_fee(unsigned int tx_no) const { return _tx_fee[tx_no - _base]; }
+        double get_broadcast_time(unsigned int tx_no) const { return _broadcast_time[tx_no - _base]; }
+        bool is_confirmed(unsigned int tx_no) const { return _confirmation_time[tx_no - _base] >= 0; }
+        double get_confirmation_time(unsigned int tx_no) const { return _confirmation_time[tx_no - _base]; } // time of first inclusion in a block
+        void set_confirmation_time(unsigned int tx_no, double conf_time) { _confirmation_time[tx_no - _base] = conf_time; }
+        void trim(unsigned int floor) { // forget the txs numbered below floor
+            if (floor <= _base) return;
+            size_t count = min((size_t)(floor - _base), _tx_fee.size());
+            _tx_fee.erase(_tx_fee.begin(), _tx_fee.begin() + count);
+            _broadcast_time.erase(_broadcast_time.begin(), _broadcast_time.begin() + count);
+            _confirmation_time.erase(_confirmation_time.begin(), _confirmation_time.begin() + count);
+            _base += count;
+        }
+        void save(SnapshotWriter& out) const {
+            out.put(_base);
+            out.put(_tx_fee);
+            out.put(_broadcast_time);
+            out.put(_confirmation_time);
+        }
+        void restore(SnapshotReader& in) {
+            _base = in.get<unsigned int>();
+            in.get(_tx_fee);
+            in.get(_broadcast_time);
+            in.get(_confirmation_time);
+        }
+    private:
+        unsigned int _base; // the number of the first tx in the columns
+        vector<float> _tx_fee;
+        vector<double> _broadcast_time;
+        vector<double> _confirmation_time; // -1 until the tx is included in a block
+};
+
+#endif
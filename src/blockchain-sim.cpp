@@ -1,264 +1,212 @@
 
 // The code below simulates a P2P network similar to Bitcoin.
 
-#include "Node.h"
+#include "Simulation.h"
+#include "Runner.h"
+#include "Scenario.h"
+#include "Snapshot.h"
+#include "Tracer.h"
 #include "simlib.h"
-#include <iostream>
-#include <vector>
-#include <time.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
 #include <unistd.h>
-#include <algorithm>
-#include <unordered_set>
-#include "blockchain-sim-defs.h"
+#include <string>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
-int num_blocks, num_transactions, min_links_per_node;
-float mean_tx_interarrival, mean_block_interarrival, mean_link_speed;
-FILE *infile;
-vector<Node*>* node_list;
-
-void init_model(); // initialize the model
-void add_link(Node* node1, Node* node2, float speed); // add a communication link between nodes
-void new_transaction(); // run for every new transaction event
-void new_block(); // run for every new block event
-void tx_relay(); // run when transactions are relayed to nodes
-void block_relay(); // run when blocks are relayed to nodes
-void report(); // print statistics from the simulation run
+uint64_t random_seed(); // seed from /dev/urandom
+void print_usage(); // print command line usage to stderr
 
 int main(int argc, char* argv[]) {
 
-    if (argc == 5) {
-      min_links_per_node = atof(argv[1]);
-      mean_tx_interarrival = atof(argv[2]);
-      mean_block_interarrival = atof(argv[3]);
-      mean_link_speed = atof(argv[4]);
-    } else {
-      fprintf(stderr, "Usage: ./blockchain-sim <min_links_per_node> <mean_tx_interarrival> <mean_block_interarrival> <mean_link_speed>\n");
-      return 1;
-    }
-
-    // Write report heading with input parameters.
-    printf("Mean interarrival time for transactions: %.3f\n", mean_tx_interarrival);
-    printf("Mean interarrival time for blocks: %.3f\n", mean_block_interarrival);
-    printf("Mean link speed: %.3f\n", mean_link_speed);
-    printf("Min links per node: %d\n", min_links_per_node);
-
-    // initialize simlib
-    init_simlib();
-
-    // set number of attributes per record
-    maxatr = 7;
-
-    // initialize model
-    init_model();
-
-    // run the simulation until enough blocks are mined
-    while (num_blocks < MAX_BLOCKS) {
-        // determine the next event
-        timing();
-        
-        // invoke the appropriate event function
-        switch(next_event_type) {
-            case EVENT_NEW_TRANSACTION:
-                new_transaction();
+    Scenario scenario;
+    scenario.seed = random_seed();
+    const char* scenario_file = NULL;
+    bool study = false; // print result rows rather than a single run's report
+
+    // parse options; they are applied after the scenario file, so they override it
+    vector<pair<string, string> > settings;
+    int opt;
+    while ((opt = getopt(argc, argv, "q:r:j:s:f:o:l:w:t:b:x:")) != -1) {
+        switch (opt) {
+            case 'q': // event list implementation
+                settings.push_back(make_pair("event_list", optarg));
+                break;
+            case 'r': // replications per parameter point
+                settings.push_back(make_pair("replications", optarg));
+                break;
+            case 'j': // worker threads
+                settings.push_back(make_pair("threads", optarg));
+                break;
+            case 's': // base seed
+                settings.push_back(make_pair("seed", optarg));
+                break;
+            case 'f': // scenario file
+                scenario_file = optarg;
+                study = true;
+                break;
+            case 'o': // result row format
+                settings.push_back(make_pair("output", optarg));
+                study = true;
                 break;
-            case EVENT_NEW_BLOCK:
-                new_block();
+            case 'l': // snapshot to start from
+                settings.push_back(make_pair("restore", optarg));
                 break;
-            case EVENT_TX_RELAY:
-                tx_relay();
+            case 'w': // snapshot to save
+                settings.push_back(make_pair("snapshot", optarg));
                 break;
-            case EVENT_BLOCK_RELAY:
-                block_relay();
+            case 't': // when to save it
+                settings.push_back(make_pair("snapshot_at", optarg));
                 break;
+            case 'b': // when the points branch off
+                settings.push_back(make_pair("branch_at", optarg));
+                study = true;
+                break;
+            case 'x': // trace file
+                settings.push_back(make_pair("trace", optarg));
+                break;
+            default:
+                print_usage();
+                return 1;
         }
     }
 
-    // write out a report
-    report();
-
-    // free memory and exit
-    for (vector<Node*>::iterator it = node_list->begin(); it != node_list->end(); ++it) {
-        delete *it;
+    if (argc - optind == 4) {
+      settings.push_back(make_pair("min_links_per_node", argv[optind]));
+      settings.push_back(make_pair("mean_tx_interarrival", argv[optind + 1]));
+      settings.push_back(make_pair("mean_block_interarrival", argv[optind + 2]));
+      settings.push_back(make_pair("mean_link_speed", argv[optind + 3]));
+    } else if (argc - optind != 0 || scenario_file == NULL) {
+      print_usage();
+      return 1;
     }
-    return 0;
-}
-
-void init_model() {
-    // allocate memory for a vector of nodes
-    node_list = new vector<Node*>;
-
-    // initialize statistical variables and random number streams
-    num_blocks = 0;
-    num_transactions = 0;
 
-    //modified code with get random data from /dev/urandom instead of time
-    int from_urandom;
-    FILE* fp;
-    fp = fopen("/dev/urandom", "r");
-    if (fp != NULL) {
-      fread(&from_urandom, 1, sizeof(int), fp);
-      srand(from_urandom);
-      fread(&from_urandom, 1, sizeof(int), fp);
-      lcgrandst(from_urandom, STREAM_TX_INTERARRIVAL);
-      fread(&from_urandom, 1, sizeof(int), fp);
-      lcgrandst(from_urandom, STREAM_BLOCK_INTERARRIVAL);
-      fread(&from_urandom, 1, sizeof(int), fp);
-      lcgrandst(from_urandom, STREAM_LINK_SPEED);
-      
-      fclose(fp);
-    } else { //fall back on time if /dev/urandom fails for some reason
-      srand(time(NULL) / 2);
-      lcgrandst((time(NULL) + getpid()), STREAM_TX_INTERARRIVAL);
-      lcgrandst((time(NULL) / 4), STREAM_BLOCK_INTERARRIVAL);
-      lcgrandst((time(NULL) - getpid()), STREAM_LINK_SPEED);
+    if (scenario_file != NULL && !scenario.load(scenario_file)) return 1;
+    for (vector<pair<string, string> >::iterator it = settings.begin(); it != settings.end(); ++it) {
+        if (!scenario.set(it->first, it->second)) {
+            fprintf(stderr, "Invalid value '%s' for %s\n", it->second.c_str(), it->first.c_str());
+            return 1;
+        }
     }
 
-    // add nodes to the node_list
-    unsigned int num_miners = MINER_FRACTION * NUMBER_NODES;
-    unsigned int num_relays = NUMBER_NODES - num_miners;
-    for (unsigned int i = 0; i < num_miners; ++i) {
-        Node* n = new Node(MINER, i);
-        n->set_greediness(rand() % 100 + 1);
-        node_list->push_back(n);
-        #ifdef DEBUG
-        printf("created MINER node %d\n", i);
-        #endif
-    }
-    for (unsigned int i = 0; i < num_relays; ++i) {
-        Node* n = new Node(RELAY, num_miners + i);
-        node_list->push_back(n);
-        #ifdef DEBUG
-        printf("created RELAY node %d\n", num_miners + i);
-        #endif
+    // every combination of the swept values is a parameter point
+    vector<Parameters> points = scenario.points();
+    for (vector<Parameters>::iterator it = points.begin(); it != points.end(); ++it) {
+        const char* problem = it->check();
+        if (problem != NULL) {
+            fprintf(stderr, "Cannot run this scenario: %s\n", problem);
+            return 1;
+        }
     }
 
-    // add links between nodes based on min_links_per_node and mean_link_speed
-    for (vector<Node*>::iterator it = node_list->begin(); it != node_list->end(); ++it) {
-        while ((*it)->get_num_links() < min_links_per_node) { // if more links are needed
-            unsigned int node1 = (*it)->get_node_no();
-            // find a node to link with
-            unsigned int node2 = rand() % NUMBER_NODES;
-            while (node1 == node2 || (*it)->linked_to(node2)) {
-                node2 = rand() % NUMBER_NODES;
+    // every run may start from a snapshot, and a single run may be saved to one
+    Snapshot start;
+    if (!scenario.restore.empty()) {
+        if (!start.map(scenario.restore.c_str())) return 1;
+        for (vector<Parameters>::iterator it = points.begin(); it != points.end(); ++it) {
+            const char* problem = start.check(*it);
+            if (problem != NULL) {
+                fprintf(stderr, "Cannot start from snapshot '%s': %s\n", scenario.restore.c_str(), problem);
+                return 1;
             }
-            #ifdef DEBUG
-            printf("linking node %d to node %d\n", node1, node2);
-            #endif
-            add_link(*it, node_list->at(node2), expon(mean_link_speed, STREAM_LINK_SPEED));
         }
     }
-
-    // schedule the first transaction and first block to occur
-    event_schedule(sim_time + expon(mean_tx_interarrival, STREAM_TX_INTERARRIVAL), EVENT_NEW_TRANSACTION);
-    event_schedule(sim_time + expon(mean_block_interarrival, STREAM_BLOCK_INTERARRIVAL), EVENT_NEW_BLOCK);
-}
-
-void new_transaction() {
-    ++num_transactions;
-
-    unsigned int random_index = rand() % NUMBER_NODES;
-
-    // the node should decide the tx fee
-    float tx_fee = node_list->at(random_index)->decide_tx_fee();
-
-    #ifdef DEBUG
-    printf("new_transaction() %d from %d with fee %f at t=%f\n", num_transactions, random_index, tx_fee, sim_time);
-    #endif
-
-    Transaction tx = Transaction(num_transactions, tx_fee, sim_time);
-
-    // let the network know about the transaction
-    node_list->at(random_index)->broadcast_transaction(tx);
-
-    // schedule the next transaction
-    event_schedule(sim_time + expon(mean_tx_interarrival, STREAM_TX_INTERARRIVAL), EVENT_NEW_TRANSACTION);
-}
-
-void new_block() {
-    ++num_blocks;
-
-    unsigned int random_index = rand() % NUMBER_NODES;
-    while (!(node_list->at(random_index)->get_type() == MINER)) {
-        random_index = rand() % NUMBER_NODES;
+    if (!scenario.snapshot.empty()) {
+        const char* problem = points.size() > 1 || scenario.replications > 1 ? "a snapshot is saved of a single run"
+                                                                               : Snapshot::cannot_save(points[0]);
+        if (problem != NULL) {
+            fprintf(stderr, "Cannot save a snapshot: %s\n", problem);
+            return 1;
+        }
+    }
+    // branches start from a snapshot of the first point's run
+    if (scenario.branch_at >= 0) {
+        const char* problem = !scenario.snapshot.empty() ? "branches cannot be saved to a snapshot"
+                                                         : Snapshot::cannot_save(points[0]);
+        for (size_t i = 1; problem == NULL && i < points.size(); ++i) problem = Snapshot::mismatch(points[0], points[i]);
+        if (problem != NULL) {
+            fprintf(stderr, "Cannot branch: %s\n", problem);
+            return 1;
+        }
+    }
+    // and a single run may be traced
+    if (!scenario.trace.empty()) {
+        const char* problem = points.size() > 1 || scenario.replications > 1 || scenario.branch_at >= 0
+                              ? "a trace is written of a single run" : Tracer::cannot_trace(points[0]);
+        if (problem != NULL) {
+            fprintf(stderr, "Cannot trace the run: %s\n", problem);
+            return 1;
+        }
+    }
+    const Snapshot* start_from = scenario.restore.empty() ? NULL : &start;
+
+    if (study || points.size() > 1 || scenario.replications > 1) {
+        // a study: summarize every point across its replications
+        Runner runner(points, scenario.replications, scenario.seed, start_from);
+        if (!scenario.snapshot.empty()) runner.save(scenario.snapshot.c_str(), scenario.snapshot_at);
+        if (scenario.branch_at >= 0) runner.branch(scenario.branch_at);
+        if (!scenario.trace.empty()) runner.trace(scenario.trace.c_str());
+        runner.run(scenario.num_threads, stdout, scenario.output);
+        return 0;
     }
 
-    #ifdef DEBUG
-    printf("new_block() from %d\n", random_index);
-    #endif
-
-    float block_time = sim_time;
-
-    int number_of_reward_changes = num_blocks / BLOCKS_BETWEEN_REWARD_CHANGES;
-    float block_reward = DEFAULT_BLOCK_REWARD / pow(2, number_of_reward_changes);
-
-    vector<Transaction>* tx_list = node_list->at(random_index)->decide_included_tx_list(block_reward, block_time);
-
-    Block* b = new Block(num_blocks, tx_list, block_time, block_reward);
-
-    // let the network know about the block
-    node_list->at(random_index)->broadcast_block(b);
-
-    // schedule the next block
-    event_schedule(sim_time + expon(mean_block_interarrival, STREAM_BLOCK_INTERARRIVAL), EVENT_NEW_BLOCK);
-}
+    // Write report heading with input parameters.
+    Parameters& params = points[0];
+    printf("Mean interarrival time for transactions: %.3f\n", params.mean_tx_interarrival);
+    printf("Mean interarrival time for blocks: %.3f\n", params.mean_block_interarrival);
+    printf("Mean link speed: %.3f\n", params.mean_link_speed);
+    printf("Min links per node: %d\n", params.min_links_per_node);
+
+    // set up the run
+    Simulation sim(params, scenario.seed, start_from);
+    if (!scenario.trace.empty() && !sim.trace(scenario.trace.c_str())) return 1;
+
+    // run the simulation until enough blocks are mined, saving it on the way if asked to
+    if (!scenario.snapshot.empty()) {
+        sim.run(scenario.snapshot_at);
+        if (!sim.save(scenario.snapshot.c_str())) return 1;
+    }
+    sim.run();
 
-void tx_relay() {
-    unsigned int tx_no = transfer[3];
-    float tx_fee = transfer[4];
-    unsigned int node_no = transfer[5];
-    float broadcast_time = transfer[6];
-    #ifdef DEBUG
-    printf("tx_relay() of tx %d to node %d\n", tx_no, node_no);
-    #endif
-    Transaction tx = Transaction(tx_no, tx_fee, broadcast_time);
-    node_list->at(node_no)->broadcast_transaction(tx);
-}
+    // write out a report
+    sim.report(stdout);
 
-void block_relay() {
-    unsigned int block_no = transfer[3];
-    unsigned int from_node = transfer[4];
-    unsigned int to_node = transfer[5];
-    float block_time = transfer[6];
-    float block_reward = transfer[7];
-    #ifdef DEBUG
-    printf("block_relay() of block %d from node %d to node %d\n", block_no, from_node, to_node);
-    #endif
-    vector<Transaction>* transactions = node_list->at(from_node)->get_block_transactions(block_no);
-    Block* b = new Block(block_no, transactions, block_time, block_reward);
-    node_list->at(to_node)->broadcast_block(b);
+    return 0;
 }
 
-void report() {
-    printf("Number of blocks: %d\n", num_blocks);
-    printf("Number of transactions: %d\n", num_transactions);
-    sampst(0.0, -SAMPST_TTC);
-    printf("Avg time-to-confirmation: %f\n", transfer[1]);
-    sampst(0.0, -SAMPST_TX_FEE);
-    printf("Avg tx fee: %f\n", transfer[1]);
-    // find number of confirmed and uncomfirmed transactions
-    unordered_set<unsigned int> confirmed_tx_nos, known_tx_nos;
-    for (vector<Node*>::iterator it = node_list->begin(); it != node_list->end(); ++it) {
-        vector<Transaction>* tx_list = (*it)->get_known_transactions();
-        for (vector<Transaction>::iterator it2 = tx_list->begin(); it2 != tx_list->end(); ++it2) {
-            known_tx_nos.insert(it2->get_tx_no());
-        }
-        vector<Block*>* block_list = (*it)->get_known_blocks();
-        for (vector<Block*>::iterator it3 = block_list->begin(); it3 != block_list->end(); ++it3) {
-            vector<Transaction>* block_tx_list = (*it3)->get_transactions();
-            for (vector<Transaction>::iterator it4 = block_tx_list->begin(); it4 != block_tx_list->end(); ++it4) {
-                confirmed_tx_nos.insert(it4->get_tx_no());
-                known_tx_nos.insert(it4->get_tx_no());
-            }
-        }
+uint64_t random_seed() {
+    //get random data from /dev/urandom instead of time
+    uint64_t seed;
+    FILE* fp;
+    fp = fopen("/dev/urandom", "r");
+    if (fp != NULL && fread(&seed, 1, sizeof(seed), fp) == sizeof(seed)) {
+      fclose(fp);
+      return seed;
     }
-    printf("%% confirmed transactions: %f\n", ((float)confirmed_tx_nos.size() / (float)known_tx_nos.size()));
-    //TODO print rest of report
+    //fall back on time if /dev/urandom fails for some reason
+    if (fp != NULL) fclose(fp);
+    return ((uint64_t)time(NULL) << 32) ^ getpid();
 }
 
-void add_link(Node* node1, Node* node2, float speed) {
-    node1->add_link(node2, speed);
-    node2->add_link(node1, speed);
+void print_usage() {
+    fprintf(stderr, "Usage: ./blockchain-sim [-q heap|calendar] [-r replications] [-j threads] [-s seed]\n"
+                    "                        [-f scenario] [-o table|csv|json] [-l snapshot] [-w snapshot -t time]\n"
+                    "                        [-b time] [-x trace]\n"
+                    "                        <min_links_per_node> <mean_tx_interarrival> <mean_block_interarrival> <mean_link_speed>\n");
+    fprintf(stderr, "  -q  event list implementation (default: heap)\n");
+    fprintf(stderr, "  -r  replications of every parameter point (default: 1)\n");
+    fprintf(stderr, "  -j  worker threads for replications (default: one per core)\n");
+    fprintf(stderr, "  -s  base seed; replication r of every point uses seed + r (default: random)\n");
+    fprintf(stderr, "  -f  scenario file of name = value settings; the four parameters may then be omitted\n");
+    fprintf(stderr, "  -o  format of result rows (default: table)\n");
+    fprintf(stderr, "  -l  start every run from a snapshot file\n");
+    fprintf(stderr, "  -w  save the run to a snapshot file when it reaches the time given with -t (default: 0)\n");
+    fprintf(stderr, "  -b  run the first parameter point to this time once per replication, then every point on from there\n");
+    fprintf(stderr, "  -x  write a binary trace of every tx and block arrival to a file; see ./blockchain-trace\n");
+    fprintf(stderr, "Each parameter may be a comma-separated list or a from:to:step range; every\n");
+    fprintf(stderr, "combination is run. For a study (more than one run, or -f or -o), one row of\n");
+    fprintf(stderr, "means and 95%% confidence interval half-widths is printed per parameter point.\n");
 }
@@ -0,0 +1,229 @@
+// Reads a trace written by blockchain-sim -x (see Tracer.h): prints the
+// propagation curves of transactions and blocks, or replays the run as one
+// line per record.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "Tracer.h"
+
+using namespace std;
+
+// shares of the nodes reached that the curve reports the time to
+static const double shares[] = { 0.5, 0.9, 1.0 };
+static const int num_shares = sizeof(shares) / sizeof(shares[0]);
+
+// a tx or block, as far as the trace shows it
+struct Item {
+    double created; // NAN if it was created before the trace began
+    unsigned int reached; // nodes
+    unsigned int copies; // arrivals at nodes that had already seen it
+    double time_to[num_shares]; // after creation, NAN until reached
+    vector<bool> nodes; // reached, once it was created in the trace
+};
+
+// the items of one kind (txs or blocks) and the arrivals' times after creation
+struct Kind {
+    const char* name;
+    vector<Item> items;
+    double horizon; // the longest time after creation of any arrival
+    vector<double> delays; // of the arrivals of the items that count
+};
+
+int curve(const TraceFile& trace, int points);
+int replay(const TraceFile& trace, double from, double to);
+void print_usage(); // print command line usage to stderr
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+    TraceFile trace;
+    if (!trace.map(argv[2])) return 1;
+    if (strcmp(argv[1], "curve") == 0 && argc <= 4) {
+        int points = argc == 4 ? atoi(argv[3]) : 20;
+        if (points < 2) {
+            print_usage();
+            return 1;
+        }
+        return curve(trace, points);
+    }
+    if (strcmp(argv[1], "replay") == 0 && argc <= 5) {
+        double from = argc >= 4 ? atof(argv[3]) : -INFINITY;
+        double to = argc == 5 ? atof(argv[4]) : INFINITY;
+        return replay(trace, from, to);
+    }
+    print_usage();
+    return 1;
+}
+
+static bool is_tx(const TraceRecord* r) {
+    return r->kind == TRACE_NEW_TX || r->kind == TRACE_TX_ARRIVAL || r->kind == TRACE_TX_COPY;
+}
+
+// the time of q (0 to 1) of the sorted values
+static double quantile(const vector<double>& sorted, double q) {
+    if (sorted.empty()) return NAN;
+    return sorted[min(sorted.size() - 1, (size_t)(q * sorted.size()))];
+}
+
+int curve(const TraceFile& trace, int points) {
+    unsigned int num_nodes = trace.num_nodes();
+    vector<const TraceRecord*> records;
+    trace.sorted(records);
+    if (records.empty()) {
+        fprintf(stderr, "The trace has no records\n");
+        return 1;
+    }
+    double begin = records.front()->time, end = records.back()->time;
+
+    // Txs and blocks are numbered from 0 as they are created, so one that
+    // reaches a node has a lower number than the last one the trace creates.
+    Kind kinds[2];
+    kinds[0].name = "txs";
+    kinds[1].name = "blocks";
+    kinds[0].horizon = kinds[1].horizon = 0;
+    Item unknown = { NAN, 0, 0, { NAN, NAN, NAN } };
+    for (vector<const TraceRecord*>::iterator it = records.begin(); it != records.end(); ++it) {
+        const TraceRecord* r = *it;
+        Kind& kind = kinds[r->kind == TRACE_NEW_TX ? 0 : 1];
+        if ((r->kind == TRACE_NEW_TX || r->kind == TRACE_NEW_BLOCK) && r->no >= kind.items.size()) {
+            kind.items.resize((size_t)r->no + 1, unknown);
+        }
+    }
+    vector<bool> first(records.size(), false); // the records of items' first arrivals at nodes
+    for (size_t j = 0; j < records.size(); ++j) {
+        const TraceRecord* r = records[j];
+        Kind& kind = kinds[is_tx(r) ? 0 : 1];
+        if (r->no >= kind.items.size()) {
+            // none of this kind were created in the trace, so none count
+            if (kind.items.empty()) continue;
+            fprintf(stderr, "The trace is damaged: %s %u reaches node %d after the last one was created\n",
+                    kind.name, r->no, r->to_node);
+            return 1;
+        }
+        Item& item = kind.items[r->no];
+        if (r->kind == TRACE_NEW_TX || r->kind == TRACE_NEW_BLOCK) {
+            item.created = r->time;
+        } else if (r->kind == TRACE_TX_COPY || r->kind == TRACE_BLOCK_COPY) {
+            ++item.copies;
+            continue;
+        }
+        if (isnan(item.created)) continue;
+        // a node may get an item more than once, and only the first time counts
+        if (item.nodes.empty()) item.nodes.resize(num_nodes, false);
+        if (item.nodes[r->to_node]) {
+            ++item.copies;
+            continue;
+        }
+        item.nodes[r->to_node] = true;
+        first[j] = true;
+        double delay = r->time - item.created;
+        kind.horizon = max(kind.horizon, delay);
+        ++item.reached;
+        for (int i = 0; i < num_shares; ++i) {
+            if (item.reached == (unsigned int)ceil(shares[i] * num_nodes)) item.time_to[i] = delay;
+        }
+    }
+
+    // Items created late in the trace may not have spread yet when it ends.
+    // Only those created at least the longest delay seen before the end count.
+    printf("# %zu records of a run of %u nodes with seed %llu, from time %f to %f\n", records.size(), num_nodes,
+           (unsigned long long)trace.seed(), begin, end);
+    double longest = max(kinds[0].horizon, kinds[1].horizon);
+    size_t counted[2];
+    for (int k = 0; k < 2; ++k) {
+        Kind& kind = kinds[k];
+        counted[k] = 0;
+        size_t reached = 0, copies = 0;
+        vector<double> times_to[num_shares];
+        for (vector<Item>::iterator it = kind.items.begin(); it != kind.items.end(); ++it) {
+            if (isnan(it->created) || it->created > end - kind.horizon) continue;
+            ++counted[k];
+            reached += it->reached;
+            copies += it->copies;
+            for (int i = 0; i < num_shares; ++i) {
+                if (!isnan(it->time_to[i])) times_to[i].push_back(it->time_to[i]);
+            }
+        }
+        printf("# %s: %zu created before time %f; %f copies per node reached\n", kind.name, counted[k],
+               end - kind.horizon, reached > 0 ? (double)copies / reached : 0);
+        for (int i = 0; i < num_shares; ++i) {
+            vector<double>& times = times_to[i];
+            sort(times.begin(), times.end());
+            double mean = 0;
+            for (size_t j = 0; j < times.size(); ++j) mean += times[j];
+            if (!times.empty()) mean /= times.size();
+            printf("#   time to reach %.0f%% of nodes, for the %zu that did: mean/p50/p90/p99: %f/%f/%f/%f\n",
+                   shares[i] * 100, times.size(), mean, quantile(times, 0.5), quantile(times, 0.9),
+                   quantile(times, 0.99));
+        }
+    }
+
+    // the delays of the counted items' arrivals, for the curve
+    for (size_t j = 0; j < records.size(); ++j) {
+        if (!first[j]) continue;
+        const TraceRecord* r = records[j];
+        int k = is_tx(r) ? 0 : 1;
+        const Item& item = kinds[k].items[r->no];
+        if (isnan(item.created) || item.created > end - kinds[k].horizon) continue;
+        kinds[k].delays.push_back(r->time - item.created);
+    }
+
+    // the share of nodes an item has reached, on average, by every delay
+    printf("delay\ttxs\tblocks\n");
+    size_t next[2] = { 0, 0 };
+    for (int k = 0; k < 2; ++k) sort(kinds[k].delays.begin(), kinds[k].delays.end());
+    for (int p = 0; p < points; ++p) {
+        double delay = longest * p / (points - 1);
+        printf("%f", delay);
+        for (int k = 0; k < 2; ++k) {
+            const vector<double>& delays = kinds[k].delays;
+            while (next[k] < delays.size() && delays[next[k]] <= delay) ++next[k];
+            printf("\t%f", counted[k] > 0 ? (double)next[k] / counted[k] / num_nodes : 0);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+int replay(const TraceFile& trace, double from, double to) {
+    vector<const TraceRecord*> records;
+    trace.sorted(records);
+    for (vector<const TraceRecord*>::iterator it = records.begin(); it != records.end(); ++it) {
+        const TraceRecord* r = *it;
+        if (r->time < from) continue;
+        if (r->time > to) break;
+        switch (r->kind) {
+            case TRACE_NEW_TX:
+                printf("%f new tx %u at node %d\n", r->time, r->no, r->to_node);
+                break;
+            case TRACE_NEW_BLOCK:
+                printf("%f new block %u at node %d\n", r->time, r->no, r->to_node);
+                break;
+            case TRACE_TX_ARRIVAL:
+            case TRACE_TX_COPY:
+                printf("%f tx %u from node %d to node %d%s\n", r->time, r->no, r->from_node, r->to_node,
+                       r->kind == TRACE_TX_COPY ? " (seen)" : "");
+                break;
+            case TRACE_BLOCK_ARRIVAL:
+            case TRACE_BLOCK_COPY:
+                printf("%f block %u from node %d to node %d%s\n", r->time, r->no, r->from_node, r->to_node,
+                       r->kind == TRACE_BLOCK_COPY ? " (seen)" : "");
+                break;
+        }
+    }
+    return 0;
+}
+
+void print_usage() {
+    fprintf(stderr, "Usage: ./blockchain-trace curve <trace> [points]\n"
+                    "       ./blockchain-trace replay <trace> [from [to]]\n");
+    fprintf(stderr, "  curve   times for txs and blocks to reach 50%%, 90%% and all of the nodes, and the share\n");
+    fprintf(stderr, "          of nodes reached by each of points delays after creation (default: 20)\n");
+    fprintf(stderr, "  replay  one line per creation and arrival, in time order, between times from and to\n");
+}
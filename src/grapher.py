@@ -5,36 +5,25 @@
 
 import matplotlib.pyplot as plt
 import subprocess
-from tqdm import tqdm
 
-def one_run(which_result, *args):
-    """Run the blockchain-sim program with same args as this function"""
-    string =  subprocess.check_output(["./blockchain-sim"] +
-                                      list(args)).decode('utf-8')
-    lines = string.split('\n')
+def sweep(nruns, which_result, *args):
+    """Run the blockchain-sim program once for every parameter point in args
+    (comma-separated lists), nruns replications each, and return the mean and
+    95% confidence interval half-width of which_result at every point"""
+    string = subprocess.check_output(["./blockchain-sim", "-r", str(nruns)] +
+                                     list(args)).decode('utf-8')
+    lines = string.strip().split('\n')
 
-    # a better way to do this would be a pattern search, but I'm hardcoding
-    # locations for now
-    num_blocks = int(lines[4].split()[3])
-    num_transactions = int(lines[5].split()[3])
-    avg_ttc = float(lines[6].split()[2])
-    avg_fee = float(lines[7].split()[3])
-    percent_confirmed = float(lines[8].split()[3])
+    # one tab-separated row per point, after a header naming the columns
+    header = lines[0].split('\t')
+    column = header.index(['avg_ttc', 'avg_tx_fee', 'confirmed'][which_result])
+    rows = [line.split('\t') for line in lines[1:]]
+    return ([float(row[column]) for row in rows],
+            [float(row[column + 1]) for row in rows])
 
-    if which_result == 0:
-        return avg_ttc
-    if which_result == 1:
-        return avg_fee
-    if which_result == 2:
-        return percent_confirmed
-
-def avg_of_runs(nruns, which_result, *args):
-    """Take n runs with args and average which_result"""
-    return sum(one_run(which_result, *args) for _ in tqdm(range(nruns))) / nruns
-
-def graph_it(x_list, y_list, labels, indep, dep):
-    """Take input list, output list, and axis labels, and make a graph"""
-    plt.plot(x_list, y_list)
+def graph_it(x_list, y_list, y_err, labels, indep, dep):
+    """Take input list, output list, confidence intervals, and axis labels, and make a graph"""
+    plt.errorbar(x_list, y_list, yerr=y_err, capsize=3)
     plt.xlabel(labels[indep]['x'])
     plt.ylabel(labels[dep]['y'])
     plt.title(labels[dep]['y'] + " vs. " + labels[indep]['x'])
@@ -84,17 +73,19 @@ def main(argv):
                         for x in mean_link_speed]
 
 
-    results = []
-    for varset in tqdm(independents):
-        results.append(avg_of_runs(nruns, dep_var, varset['min_connectivity'], varset['mean_tx_interarrival'],
-                                   varset['mean_block_interarrival'], varset['mean_link_speed']))
+    # pass every value of each parameter at once; the simulator runs all the
+    # points in one process, replications in parallel
+    varset = {key: ','.join(dict.fromkeys(x[key] for x in independents))
+              for key in independents[0]}
+    results, errors = sweep(nruns, dep_var, varset['min_connectivity'], varset['mean_tx_interarrival'],
+                            varset['mean_block_interarrival'], varset['mean_link_speed'])
 
     # TODO: make this dynamic
     labels = [{'x':'Minimum Connectivity', 'y':'Average Time to Confirmation'},
               {'x':'Mean Transaction Interarrival Time', 'y':'Average Fee'},
               {'x':'Mean Link Latency', 'y':'Percent of Transactions Confirmed'}]
     print(results)
-    graph_it(varied, results, labels, indep_var, dep_var)
+    graph_it(varied, results, errors, labels, indep_var, dep_var)
 
 if __name__ == '__main__':
     import sys
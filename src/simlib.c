@@ -5,87 +5,248 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include "simlibdefs.h"
-
-/* Declare simlib global variables. */
-
-int    *list_rank, *list_size, next_event_type, maxatr = 0, maxlist = 0;
-float  *transfer, sim_time, prob_distrib[26];
-struct master {
-    float  *value;
-    struct master *pr;
-    struct master *sr;
-} **head, **tail;
-
-/* Declare simlib functions. */
-
-void  init_simlib(void);
-void  list_file(int option, int list);
-void  list_remove(int option, int list);
-void  timing(void);
-void  event_schedule(float time_of_event, int type_of_event);
-int   event_cancel(int event_type);
-float sampst(float value, int variable);
-float timest(float value, int variable);
-float filest(int list);
-void  out_sampst(FILE *unit, int lowvar, int highvar);
-void  out_timest(FILE *unit, int lowvar, int highvar);
-void  out_filest(FILE *unit, int lowlist, int highlist);
-void  pprint_out(FILE *unit, int i);
-float expon(float mean, int stream);
-int   random_integer(float prob_distrib[], int stream);
-float uniform(float a, float b, int stream);
-float erlang(int m, float mean, int stream);
-float lcgrand(int stream);
-void  lcgrandst(long zset, int stream);
-long  lcgrandgt(int stream);
-
+#include <string.h>
+#include "simlib.h"
+
+/* All simlib state lives in a struct simlib context (see simlib.h), which
+   every simlib function takes as its first argument, so any number of
+   independent simulations can run in one process.
+
+   The event list is not a linked list like the others.  A pending event is
+   named by a handle from the time it is scheduled until it occurs or is
+   cancelled.  event_rec[handle] holds the event itself, stored by value with
+   its typed attributes, and event_seq[handle] its sequence number; ties on
+   event time are broken by the sequence number, which preserves the FIFO
+   order of the original list.  The pending events are ordered by one of two
+   structures, chosen with event_list_kind before init_simlib is called:
+
+   EVENTS_HEAP      an indexed d-ary min-heap of (time, sequence, handle) keys;
+                    filing and removing cost O(log n).  event_pos[handle] is
+                    the heap slot of the event.
+   EVENTS_CALENDAR  a calendar queue (R. Brown, CACM 31(10), 1988): an array
+                    of buckets, each a sorted doubly linked list of handles
+                    (cal_next, cal_prev) covering cal_width time units per
+                    "day".  Filing and removing cost O(1) amortized when the
+                    bucket width matches the event spacing, so the number of
+                    buckets and their width are recomputed whenever the
+                    population doubles or halves.
+
+   event_pos[handle] is -1 whenever the handle is free, whichever structure is
+   in use.
+
+   Handles are reused, so the handle that event_post gives out carries the
+   slot's generation as well: the slot in its low 32 bits and event_gen[slot]
+   above them.  A slot's generation is advanced whenever its event occurs or
+   is cancelled, so event_cancel ignores a handle whose event is gone even if
+   the slot now holds another event.  Generations wrap around after 2^31
+   reuses of one slot.
+
+   Rows of the other lists and attribute vectors (the transfer array and the
+   values of every record) are never returned to the C allocator while the
+   context is in use.  They are carved from slabs of POOL_SLAB items and
+   recycled through free lists, rows chained through their sr pointers and
+   vectors kept on a stack, so filing and removing records allocates nothing
+   once the pools have grown to the working set.  pool_in_use, pool_high and
+   pool_cap count the items in use, the high-water mark of items in use and
+   the items allocated for each pool, including the event records above.
+   free_simlib releases the slabs. */
+
+#define HEAP_ARITY 4
+#define CAL_SAMPLE 25
+#define POOL_SLAB  256
+#define GEN_SHIFT  32
+#define GEN_MASK   0x7fffffff
+#define SLOT_MASK  0xffffffffLL
+
+struct event_key {
+    double        time;
+    unsigned long seq;
+    int           handle;
+};
+
+/* The default seeds for all 100 streams, copied into each context by
+   init_simlib. */
+
+static const long zrng_default[] =
+{         1,
+ 1973272912, 281629770,  20006270,1280689831,2096730329,1933576050,
+  913566091, 246780520,1363774876, 604901985,1511192140,1259851944,
+  824064364, 150493284, 242708531,  75253171,1964472944,1202299975,
+  233217322,1911216000, 726370533, 403498145, 993232223,1103205531,
+  762430696,1922803170,1385516923,  76271663, 413682397, 726466604,
+  336157058,1432650381,1120463904, 595778810, 877722890,1046574445,
+   68911991,2088367019, 748545416, 622401386,2122378830, 640690903,
+ 1774806513,2132545692,2079249579,  78130110, 852776735,1187867272,
+ 1351423507,1645973084,1997049139, 922510944,2045512870, 898585771,
+  243649545,1004818771, 773686062, 403188473, 372279877,1901633463,
+  498067494,2087759558, 493157915, 597104727,1530940798,1814496276,
+  536444882,1663153658, 855503735,  67784357,1432404475, 619691088,
+  119025595, 880802310, 176192644,1116780070, 277854671,1366580350,
+ 1142483975,2026948561,1053920743, 786262391,1792203830,1494667770,
+ 1923011392,1433700034,1244184613,1147297105, 539712780,1545929719,
+  190641742,1645390429, 264907697, 620389253,1502074852, 927711160,
+  364849192,2049576050, 638580085, 547070247 };
 
-void init_simlib()
+/* Declare simlib internal functions. */
+
+static int  event_key_less(struct event_key *a, struct event_key *b);
+static void event_sift_up(struct simlib *sl, int pos);
+static void event_sift_down(struct simlib *sl, int pos);
+static int  event_before(struct simlib *sl, int handle1, int handle2);
+static long cal_day_of(struct simlib *sl, double time);
+static void cal_link(struct simlib *sl, int handle);
+static void cal_unlink(struct simlib *sl, int handle);
+static int  cal_first(struct simlib *sl);
+static void cal_resize(struct simlib *sl, int nbuckets);
+static int  event_file(struct simlib *sl, struct event *ev);
+static int  event_first(struct simlib *sl);
+static void event_take(struct simlib *sl, int handle, struct event *ev);
+static void pool_note(struct simlib *sl, int pool, int change);
+static void slab_keep(struct simlib *sl, void *slab);
+static struct master *row_alloc(struct simlib *sl);
+static void   row_release(struct simlib *sl, struct master *row);
+static double *attr_alloc(struct simlib *sl);
+static void   attr_release(struct simlib *sl, double *value);
+
+
+void init_simlib(struct simlib *sl)
 {
 
-/* Initialize simlib.c.  List LIST_EVENT is reserved for event list, ordered by
-   event time.  init_simlib must be called from main by user. */
+/* Initialize the simlib context sl.  List LIST_EVENT is reserved for event
+   list, ordered by event time.  init_simlib must be called on every context
+   before it is used; maxatr, maxlist and event_list_kind may be set first,
+   and are otherwise given their defaults. */
 
-    int list, listsize;
+    int list, listsize, item;
 
-    if (maxlist < 1) maxlist = MAX_LIST;
-    listsize = maxlist + 1;
+    if (sl->maxlist < 1) sl->maxlist = MAX_LIST;
+    listsize = sl->maxlist + 1;
 
     /* Initialize system attributes. */
 
-    sim_time = 0.0;
-    if (maxatr < 4) maxatr = MAX_ATTR;
+    sl->sim_time = 0.0;
+    if (sl->maxatr < 4) sl->maxatr = MAX_ATTR;
+    if (sl->event_list_kind == 0) sl->event_list_kind = EVENTS_HEAP;
+
+    /* Start every random-number stream from its default seed. */
+
+    for (item = 0; item <= 100; ++item)
+        sl->zrng[item] = zrng_default[item];
 
     /* Allocate space for the lists. */
 
-    list_rank = (int *)            calloc(listsize,   sizeof(int));
-    list_size = (int *)            calloc(listsize,   sizeof(int));
-    head      = (struct master **) calloc(listsize,   sizeof(struct master *));
-    tail      = (struct master **) calloc(listsize,   sizeof(struct master *));
-    transfer  = (float *)          calloc(maxatr + 1, sizeof(float));
+    sl->list_rank = (int *)            calloc(listsize,   sizeof(int));
+    sl->list_size = (int *)            calloc(listsize,   sizeof(int));
+    sl->head      = (struct master **) calloc(listsize,   sizeof(struct master *));
+    sl->tail      = (struct master **) calloc(listsize,   sizeof(struct master *));
+
+    /* Size attribute vectors for the largest attribute count the user can
+       ask for, then take the transfer array from the pool. */
+
+    sl->attr_size     = (sl->maxatr > MAX_ATTR ? sl->maxatr : MAX_ATTR) + 1;
+    sl->attr_num_free = 0;
+    sl->attr_free_cap = 0;
+    sl->attr_free     = NULL;
+    sl->row_free      = NULL;
+    sl->slabs         = NULL;
+    sl->num_slabs     = 0;
+    sl->slab_cap      = 0;
+    for (item = 1; item < POOL_SIZE; ++item) {
+        sl->pool_in_use[item] = 0;
+        sl->pool_high[item]   = 0;
+        sl->pool_cap[item]    = 0;
+    }
+    sl->transfer = attr_alloc(sl);
+    for (item = 0; item < sl->attr_size; ++item)
+        sl->transfer[item] = 0.0;
 
     /* Initialize list attributes. */
 
-    for(list = 1; list <= maxlist; ++list) {
-        head [list]     = NULL;
-        tail [list]     = NULL;
-        list_size[list] = 0;
-        list_rank[list] = 0;
+    for(list = 1; list <= sl->maxlist; ++list) {
+        sl->head [list]     = NULL;
+        sl->tail [list]     = NULL;
+        sl->list_size[list] = 0;
+        sl->list_rank[list] = 0;
     }
 
     /* Set event list to be ordered by event time. */
 
-    list_rank[LIST_EVENT] = EVENT_TIME;
+    sl->list_rank[LIST_EVENT] = EVENT_TIME;
+
+    /* Allocate initial event storage; it doubles as needed. */
+
+    if(!(sl->event_list_kind == EVENTS_HEAP || sl->event_list_kind == EVENTS_CALENDAR)) {
+        printf("\n%d is an invalid event list kind\n", sl->event_list_kind);
+        exit(1);
+    }
+    sl->event_cap      = 64;
+    sl->event_num_free = 0;
+    sl->event_num_seq  = 0;
+    sl->event_heap     = (struct event_key *) malloc(sl->event_cap * sizeof(struct event_key));
+    sl->event_rec      = (struct event *)     malloc(sl->event_cap * sizeof(struct event));
+    sl->event_seq      = (unsigned long *)    malloc(sl->event_cap * sizeof(unsigned long));
+    sl->event_pos      = (int *)              malloc(sl->event_cap * sizeof(int));
+    sl->event_free     = (int *)              malloc(sl->event_cap * sizeof(int));
+    sl->event_gen      = (unsigned int *)     calloc(sl->event_cap, sizeof(unsigned int));
+    sl->cal_next       = (int *)              malloc(sl->event_cap * sizeof(int));
+    sl->cal_prev       = (int *)              malloc(sl->event_cap * sizeof(int));
+    sl->cal_pending    = (int *)              malloc(sl->event_cap * sizeof(int));
+    sl->pool_cap[POOL_EVENTS] = sl->event_cap;
+    for (item = sl->event_cap - 1; item >= 0; --item) {
+        sl->event_pos[item]                  = -1;
+        sl->event_free[sl->event_num_free++] = item;
+    }
+
+    /* Start the calendar with two one-unit days; it is resized as events are
+       filed. */
+
+    sl->cal_nbuckets = 2;
+    sl->cal_width    = 1.0;
+    sl->cal_day      = 0;
+    sl->cal_bucket   = (int *) malloc(sl->cal_nbuckets * sizeof(int));
+    for (item = 0; item < sl->cal_nbuckets; ++item)
+        sl->cal_bucket[item] = -1;
 
     /* Initialize statistical routines. */
 
-    sampst(0.0, 0);
-    timest(0.0, 0);
+    sampst(sl, 0.0, 0);
+    timest(sl, 0.0, 0);
+}
+
+
+void free_simlib(struct simlib *sl)
+{
+
+/* Return all storage held by the context sl to the C allocator.  The context
+   may be reused by calling init_simlib again. */
+
+    int slab;
+
+    for (slab = 0; slab < sl->num_slabs; ++slab)
+        free(sl->slabs[slab]);
+    free(sl->slabs);
+    free(sl->attr_free);
+    free(sl->list_rank);
+    free(sl->list_size);
+    free(sl->head);
+    free(sl->tail);
+    free(sl->event_heap);
+    free(sl->event_rec);
+    free(sl->event_seq);
+    free(sl->event_pos);
+    free(sl->event_free);
+    free(sl->event_gen);
+    free(sl->cal_next);
+    free(sl->cal_prev);
+    free(sl->cal_pending);
+    free(sl->cal_bucket);
+    sl->slabs     = NULL;
+    sl->num_slabs = 0;
+    sl->slab_cap  = 0;
 }
 
 
-void list_file(int option, int list)
+void list_file(struct simlib *sl, int option, int list)
 {
 
 /* Place transfr into list "list".
@@ -102,30 +263,46 @@ void list_file(int option, int list)
     /* If the list value is improper, stop the simulation. */
 
     if(!((list >= 0) && (list <= MAX_LIST))) {
-        printf("\nInvalid list %d for list_file at time %f\n", list, sim_time);
+        printf("\nInvalid list %d for list_file at time %f\n", list, sl->sim_time);
         exit(1);
     }
 
+    /* The event list is ordered by event time, so it can only be filed in
+       increasing order.  Its records are typed events, so only the event time
+       and type are taken from transfer; use event_post to file an event with
+       attributes. */
+
+    if(list == LIST_EVENT) {
+        if(option != INCREASING) {
+            printf(
+                "\n%d is an invalid option for list_file on the event list at time %f\n",
+                option, sl->sim_time);
+            exit(1);
+        }
+        event_schedule(sl, sl->transfer[EVENT_TIME], (int)sl->transfer[EVENT_TYPE]);
+        return;
+    }
+
     /* Increment the list size. */
 
-    list_size[list]++;
+    sl->list_size[list]++;
 
     /* If the option value is improper, stop the simulation. */
 
     if(!((option >= 1) && (option <= DECREASING))) {
         printf(
             "\n%d is an invalid option for list_file on list %d at time %f\n",
-            option, list, sim_time);
+            option, list, sl->sim_time);
         exit(1);
     }
 
     /* If this is the first record in this list, just make space for it. */
 
-    if(list_size[list] == 1) {
+    if(sl->list_size[list] == 1) {
 
-        row        = (struct master *) malloc(sizeof(struct master));
-        head[list] = row ;
-        tail[list] = row ;
+        row        = row_alloc(sl);
+        sl->head[list] = row ;
+        sl->tail[list] = row ;
         (*row).pr  = NULL;
         (*row).sr  = NULL;
     }
@@ -135,60 +312,59 @@ void list_file(int option, int list)
         /* Check the value of option. */
 
         if ((option == INCREASING) || (option == DECREASING)) {
-            item = list_rank[list];
-            if(!((item >= 1) && (item <= maxatr))) {
+            item = sl->list_rank[list];
+            if(!((item >= 1) && (item <= sl->maxatr))) {
                 printf(
                     "%d is an improper value for rank of list %d at time %f\n",
-                    item, list, sim_time) ;
+                    item, list, sl->sim_time) ;
                 exit(1);
             }
 
-            row    = head[list];
+            row    = sl->head[list];
             behind = NULL; /* Dummy value for the first iteration. */
 
             /* Search for the correct location. */
 
             if (option == INCREASING) {
-                postest = (transfer[item] >= (*row).value[item]);
+                postest = (sl->transfer[item] >= (*row).value[item]);
                 while (postest) {
                     behind  = row;
                     row     = (*row).sr;
-                    postest = (behind != tail[list]);
+                    postest = (behind != sl->tail[list]);
                     if (postest)
-                        postest = (transfer[item] >= (*row).value[item]);
+                        postest = (sl->transfer[item] >= (*row).value[item]);
                 }
             }
 
             else {
 
-                postest = (transfer[item] <= (*row).value[item]);
+                postest = (sl->transfer[item] <= (*row).value[item]);
                 while (postest) {
                     behind  = row;
                     row     = (*row).sr;
-                    postest = (behind != tail[list]);
+                    postest = (behind != sl->tail[list]);
                     if (postest)
-                        postest = (transfer[item] <= (*row).value[item]);
+                        postest = (sl->transfer[item] <= (*row).value[item]);
                 }
             }
 
             /* Check to see if position is first or last.  If so, take care of
                it below. */
 
-            if (row == head[list])
+            if (row == sl->head[list])
 
                 option = FIRST;
 
             else
 
-                if (behind == tail[list])
+                if (behind == sl->tail[list])
 
                     option = LAST;
 
                 else { /* Insert between preceding and succeeding records. */
 
                     ahead        = (*behind).sr;
-                    row          = (struct master *)
-                                        malloc(sizeof(struct master));
+                    row          = row_alloc(sl);
                     (*row).pr    = behind;
                     (*behind).sr = row;
                     (*ahead).pr  = row;
@@ -197,37 +373,37 @@ void list_file(int option, int list)
         } /* End if inserting in increasing or decreasing order. */
 
         if (option == FIRST) {
-            row         = (struct master *) malloc(sizeof(struct master));
-            ihead       = head[list];
+            row         = row_alloc(sl);
+            ihead       = sl->head[list];
             (*ihead).pr = row;
             (*row).sr   = ihead;
             (*row).pr   = NULL;
-            head[list]  = row;
+            sl->head[list]  = row;
         }
         if (option == LAST) {
-            row         = (struct master *) malloc(sizeof(struct master));
-            itail       = tail[list];
+            row         = row_alloc(sl);
+            itail       = sl->tail[list];
             (*row).pr   = itail;
             (*itail).sr = row;
             (*row).sr   = NULL;
-            tail[list]  = row;
+            sl->tail[list]  = row;
         }
     }
 
     /* Copy the row values from the transfer array. */
 
-    (*row).value = (float *) calloc(maxatr + 1, sizeof(float));
-    for (item = 0; item <= maxatr; ++item)
-        (*row).value[item] = transfer[item];
+    (*row).value = attr_alloc(sl);
+    for (item = 0; item <= sl->maxatr; ++item)
+        (*row).value[item] = sl->transfer[item];
 
 
     /* Update the area under the number-in-list curve. */
 
-    timest((float)list_size[list], TIM_VAR + list);
+    timest(sl, (double)sl->list_size[list], TIM_VAR + list);
 }
 
 
-void list_remove(int option, int list)
+void list_remove(struct simlib *sl, int option, int list)
 {
 
 /* Remove a record from list "list" and copy attributes into transfer.
@@ -236,42 +412,59 @@ void list_remove(int option, int list)
             LAST  remove last record in the list */
 
     struct master *row, *ihead, *itail;
+    struct event  ev;
 
     /* If the list value is improper, stop the simulation. */
 
     if(!((list >= 0) && (list <= MAX_LIST))) {
         printf("\nInvalid list %d for list_remove at time %f\n",
-               list, sim_time);
+               list, sl->sim_time);
         exit(1);
     }
 
     /* If the list is empty, stop the simulation. */
 
-    if(list_size[list] <= 0) {
-        printf("\nUnderflow of list %d at time %f\n", list, sim_time);
+    if(sl->list_size[list] <= 0) {
+        printf("\nUnderflow of list %d at time %f\n", list, sl->sim_time);
         exit(1);
     }
 
+    /* The event list can only give up its earliest event, and only its time
+       and type are copied into transfer; event_take updates its size. */
+
+    if(list == LIST_EVENT) {
+        if(option != FIRST) {
+            printf(
+                "\n%d is an invalid option for list_remove on the event list at time %f\n",
+                option, sl->sim_time);
+            exit(1);
+        }
+        event_take(sl, event_first(sl), &ev);
+        sl->transfer[EVENT_TIME] = ev.time;
+        sl->transfer[EVENT_TYPE] = ev.type;
+        return;
+    }
+
     /* Decrement the list size. */
 
-    list_size[list]--;
+    sl->list_size[list]--;
 
     /* If the option value is improper, stop the simulation. */
 
     if(!(option == FIRST || option == LAST)) {
         printf(
             "\n%d is an invalid option for list_remove on list %d at time %f\n",
-            option, list, sim_time);
+            option, list, sl->sim_time);
         exit(1);
     }
 
-    if(list_size[list] == 0) {
+    if(sl->list_size[list] == 0) {
 
         /* There is only 1 record, so remove it. */
 
-        row        = head[list];
-        head[list] = NULL;
-        tail[list] = NULL;
+        row        = sl->head[list];
+        sl->head[list] = NULL;
+        sl->tail[list] = NULL;
     }
 
     else {
@@ -284,36 +477,36 @@ void list_remove(int option, int list)
             /* Remove the first record in the list. */
 
             case FIRST:
-                row         = head[list];
+                row         = sl->head[list];
                 ihead       = (*row).sr;
                 (*ihead).pr = NULL;
-                head[list]  = ihead;
+                sl->head[list]  = ihead;
                 break;
 
             /* Remove the last record in the list. */
 
             case LAST:
-                row         = tail[list];
+                row         = sl->tail[list];
                 itail       = (*row).pr;
                 (*itail).sr = NULL;
-                tail[list]  = itail;
+                sl->tail[list]  = itail;
                 break;
         }
     }
 
-    /* Copy the data and free memory. */
+    /* Copy the data and return the memory to the pools. */
 
-    free((char *)transfer);
-    transfer = (*row).value;
-    free((char *)row);
+    attr_release(sl, sl->transfer);
+    sl->transfer = (*row).value;
+    row_release(sl, row);
 
     /* Update the area under the number-in-list curve. */
 
-    timest((float)list_size[list], TIM_VAR + list);
+    timest(sl, (double)sl->list_size[list], TIM_VAR + list);
 }
 
 
-void timing()
+void timing(struct simlib *sl)
 {
 
 /* Remove next event from event list, placing its attributes in transfer.
@@ -322,114 +515,714 @@ void timing()
 
     /* Remove the first event from the event list and put it in transfer[]. */
 
-    list_remove(FIRST, LIST_EVENT);
+    list_remove(sl, FIRST, LIST_EVENT);
 
     /* Check for a time reversal. */
 
-    if(transfer[EVENT_TIME] < sim_time) {
+    if(sl->transfer[EVENT_TIME] < sl->sim_time) {
         printf(
             "\nAttempt to schedule event type %f for time %f at time %f\n",
-            transfer[EVENT_TYPE], transfer[EVENT_TIME], sim_time);
+            sl->transfer[EVENT_TYPE], sl->transfer[EVENT_TIME], sl->sim_time);
+        exit(1);
+    }
+
+    /* Advance the simulation clock and set the next event type. */
+
+    sl->sim_time        = sl->transfer[EVENT_TIME];
+    sl->next_event_type = sl->transfer[EVENT_TYPE];
+}
+
+
+void event_next(struct simlib *sl, struct event *ev)
+{
+
+/* Remove the next event from the event list into *ev.  Set sim_time to its
+   time and next_event_type to its type. */
+
+    /* If the event list is empty, stop the simulation. */
+
+    if(sl->list_size[LIST_EVENT] <= 0) {
+        printf("\nUnderflow of the event list at time %f\n", sl->sim_time);
+        exit(1);
+    }
+
+    event_take(sl, event_first(sl), ev);
+
+    /* Check for a time reversal. */
+
+    if(ev->time < sl->sim_time) {
+        printf(
+            "\nAttempt to schedule event type %d for time %f at time %f\n",
+            ev->type, ev->time, sl->sim_time);
         exit(1);
     }
 
     /* Advance the simulation clock and set the next event type. */
 
-    sim_time        = transfer[EVENT_TIME];
-    next_event_type = transfer[EVENT_TYPE];
+    sl->sim_time        = ev->time;
+    sl->next_event_type = ev->type;
 }
 
 
-void event_schedule(float time_of_event, int type_of_event)
+double event_time(struct simlib *sl)
 {
 
-/* Schedule an event at time event_time of type event_type.  If attributes
-   beyond the first two (reserved for the event time and the event type) are
-   being used in the event list, it is the user's responsibility to place their
-   values into the transfer array before invoking event_schedule. */
+/* Return the time of the next event on the event list without removing it,
+   or INFINITY if the event list is empty. */
 
-    transfer[EVENT_TIME] = time_of_event;
-    transfer[EVENT_TYPE] = type_of_event;
-    list_file(INCREASING, LIST_EVENT);
+    if(sl->list_size[LIST_EVENT] <= 0) return INFINITY;
+    return sl->event_rec[event_first(sl)].time;
 }
 
 
-int event_cancel(int event_type)
+void event_schedule(struct simlib *sl, double time_of_event, int type_of_event)
 {
 
-/* Remove the first event of type event_type from the event list, leaving its
-   attributes in transfer.  If something is cancelled, event_cancel returns 1;
-   if no match is found, event_cancel returns 0. */
+/* Schedule an event at time event_time of type event_type with no further
+   attributes.  Events that carry attributes are filed with event_post.  The
+   handle of the new event is left in last_event_handle for use with
+   event_cancel. */
+
+    struct event ev;
+    int    item;
+
+    ev.time = time_of_event;
+    ev.type = type_of_event;
+    for (item = 0; item < EVENT_IDS; ++item)
+        ev.id[item] = 0;
+    for (item = 0; item < EVENT_VALUES; ++item)
+        ev.value[item] = 0.0;
+    event_post(sl, &ev);
+}
 
-    struct       master *row, *ahead, *behind;
-    static float high, low, value;
 
-    /* If the event list is empty, do nothing and return 0. */
+long long event_post(struct simlib *sl, struct event *ev)
+{
 
-    if(list_size[LIST_EVENT] == 0) return 0;
+/* File a copy of *ev, whose time and type must be set, into the event list and
+   return its handle, which is also left in last_event_handle. */
 
-    /* Search the event list. */
+    int slot;
 
-    row   = head[LIST_EVENT];
-    low   = event_type - EPSILON;
-    high  = event_type + EPSILON;
-    value = (*row).value[EVENT_TYPE] ;
+    slot                  = event_file(sl, ev);
+    sl->last_event_handle = ((long long) sl->event_gen[slot] << GEN_SHIFT) | slot;
+    return sl->last_event_handle;
+}
+
+
+int event_cancel(struct simlib *sl, long long handle)
+{
+
+/* Remove the event with handle "handle" from the event list, leaving its
+   time and type in transfer.  If something is cancelled, event_cancel returns
+   1; if the handle does not name a pending event (it never did, or its event
+   has occurred or been cancelled), event_cancel returns 0. */
+
+    struct event ev;
+    int    slot;
+
+    if(handle < 0) return 0;
+    slot = (int) (handle & SLOT_MASK);
+    if(slot >= sl->event_cap || sl->event_pos[slot] < 0 ||
+       sl->event_gen[slot] != (unsigned int) (handle >> GEN_SHIFT)) return 0;
+
+    event_take(sl, slot, &ev);
+    sl->transfer[EVENT_TIME] = ev.time;
+    sl->transfer[EVENT_TYPE] = ev.type;
+    return 1;
+}
 
-    while (((value <= low) || (value >= high)) && (row != tail[LIST_EVENT])) {
-        row   = (*row).sr;
-        value = (*row).value[EVENT_TYPE];
+
+void event_visit(struct simlib *sl, void (*visit)(const struct event *ev, void *arg), void *arg)
+{
+
+/* Call visit with every pending event and arg, in no particular order. */
+
+    int handle;
+
+    for (handle = 0; handle < sl->event_cap; ++handle)
+        if (sl->event_pos[handle] >= 0) visit(&sl->event_rec[handle], arg);
+}
+
+
+static size_t state_put(void *buf, size_t pos, const void *data, size_t size)
+{
+
+/* Copy size bytes of data to position pos of buf, unless buf is NULL, and
+   return the position after them. */
+
+    if (buf != NULL) memcpy((char *) buf + pos, data, size);
+    return pos + size;
+}
+
+
+static int event_seq_compare(const void *a, const void *b)
+{
+
+/* Order event keys by sequence number alone, for qsort. */
+
+    unsigned long seq_a = ((const struct event_key *) a)->seq,
+                  seq_b = ((const struct event_key *) b)->seq;
+    return seq_a < seq_b ? -1 : seq_a > seq_b;
+}
+
+
+size_t simlib_save(struct simlib *sl, void *buf)
+{
+
+/* Write the state of the context sl into buf: the simulation clock, the
+   random-number streams, the pending events and the sampst and timest
+   accumulators.  Return the number of bytes written; with buf NULL, nothing
+   is written and only the size is worked out.  The events are written in the
+   order they were filed, so that simlib_restore files them again with their
+   ties in the same order.  Lists other than the event list are not saved, so
+   0 is returned if any of them is not empty. */
+
+    struct event_key *order;
+    struct event     *ev;
+    int    list, handle, num_events, item;
+    size_t pos;
+
+    for (list = 1; list <= sl->maxlist; ++list)
+        if (list != LIST_EVENT && sl->list_size[list] > 0) return 0;
+
+    pos = state_put(buf, 0,   &sl->sim_time, sizeof(sl->sim_time));
+    pos = state_put(buf, pos, sl->zrng,      sizeof(sl->zrng));
+
+    /* Pending events, field by field so that no padding is written. */
+
+    num_events = 0;
+    order      = (struct event_key *) malloc((sl->list_size[LIST_EVENT] + 1) * sizeof(struct event_key));
+    for (handle = 0; handle < sl->event_cap; ++handle) {
+        if (sl->event_pos[handle] < 0) continue;
+        order[num_events].seq    = sl->event_seq[handle];
+        order[num_events].handle = handle;
+        ++num_events;
     }
+    qsort(order, num_events, sizeof(struct event_key), event_seq_compare);
+    pos = state_put(buf, pos, &num_events, sizeof(num_events));
+    for (item = 0; item < num_events; ++item) {
+        ev  = &sl->event_rec[order[item].handle];
+        pos = state_put(buf, pos, &ev->time, sizeof(ev->time));
+        pos = state_put(buf, pos, &ev->type, sizeof(ev->type));
+        pos = state_put(buf, pos, ev->id,    sizeof(ev->id));
+        pos = state_put(buf, pos, ev->value, sizeof(ev->value));
+    }
+    free(order);
+
+    /* Statistics accumulators. */
+
+    pos = state_put(buf, pos, sl->sampst_count,   sizeof(sl->sampst_count));
+    pos = state_put(buf, pos, sl->sampst_max,     sizeof(sl->sampst_max));
+    pos = state_put(buf, pos, sl->sampst_min,     sizeof(sl->sampst_min));
+    pos = state_put(buf, pos, sl->sampst_sum,     sizeof(sl->sampst_sum));
+    pos = state_put(buf, pos, sl->timest_area,    sizeof(sl->timest_area));
+    pos = state_put(buf, pos, sl->timest_max,     sizeof(sl->timest_max));
+    pos = state_put(buf, pos, sl->timest_min,     sizeof(sl->timest_min));
+    pos = state_put(buf, pos, sl->timest_preval,  sizeof(sl->timest_preval));
+    pos = state_put(buf, pos, sl->timest_tlvc,    sizeof(sl->timest_tlvc));
+    pos = state_put(buf, pos, &sl->timest_treset, sizeof(sl->timest_treset));
+    return pos;
+}
+
+
+#define STATE_GET(data, size)                                   \
+    do {                                                        \
+        if (pos + (size) > len) return 0;                       \
+        memcpy((data), (const char *) buf + pos, (size));       \
+        pos += (size);                                          \
+    } while (0)
+
+size_t simlib_restore(struct simlib *sl, const void *buf, size_t len)
+{
+
+/* Read a state written by simlib_save from the len bytes at buf into the
+   context sl, which must have been initialized and have no pending events.
+   The events are filed into whichever event list sl uses.  Return the number
+   of bytes read, or 0 if buf is too short. */
 
-    /* Check to see if this is the end of the event list. */
+    struct event ev;
+    int    num_events, item;
+    size_t pos = 0;
 
-    if (row == tail[LIST_EVENT]) {
+    STATE_GET(&sl->sim_time, sizeof(sl->sim_time));
+    STATE_GET(sl->zrng,      sizeof(sl->zrng));
+
+    /* Filing the events updates the event list's timest accumulator, so the
+       accumulators are read afterwards. */
+
+    STATE_GET(&num_events, sizeof(num_events));
+    for (item = 0; item < num_events; ++item) {
+        STATE_GET(&ev.time, sizeof(ev.time));
+        STATE_GET(&ev.type, sizeof(ev.type));
+        STATE_GET(ev.id,    sizeof(ev.id));
+        STATE_GET(ev.value, sizeof(ev.value));
+        event_file(sl, &ev);
+    }
+
+    STATE_GET(sl->sampst_count,   sizeof(sl->sampst_count));
+    STATE_GET(sl->sampst_max,     sizeof(sl->sampst_max));
+    STATE_GET(sl->sampst_min,     sizeof(sl->sampst_min));
+    STATE_GET(sl->sampst_sum,     sizeof(sl->sampst_sum));
+    STATE_GET(sl->timest_area,    sizeof(sl->timest_area));
+    STATE_GET(sl->timest_max,     sizeof(sl->timest_max));
+    STATE_GET(sl->timest_min,     sizeof(sl->timest_min));
+    STATE_GET(sl->timest_preval,  sizeof(sl->timest_preval));
+    STATE_GET(sl->timest_tlvc,    sizeof(sl->timest_tlvc));
+    STATE_GET(&sl->timest_treset, sizeof(sl->timest_treset));
+    return pos;
+}
+
+#undef STATE_GET
+
+
+static int event_key_less(struct event_key *a, struct event_key *b)
+{
 
-        /* Double check to see that this is a match. */
+/* Order heap keys by event time, then by sequence number (FIFO). */
+
+    if(a->time != b->time) return a->time < b->time;
+    return a->seq < b->seq;
+}
+
+
+static void event_sift_up(struct simlib *sl, int pos)
+{
+
+/* Move the key at heap slot pos up until its parent is not larger. */
+
+    struct event_key key;
+    int    parent;
+
+    key = sl->event_heap[pos];
+    while (pos > 0) {
+        parent = (pos - 1) / HEAP_ARITY;
+        if (!event_key_less(&key, &sl->event_heap[parent])) break;
+        sl->event_heap[pos]                      = sl->event_heap[parent];
+        sl->event_pos[sl->event_heap[pos].handle]    = pos;
+        pos                                  = parent;
+    }
+    sl->event_heap[pos]           = key;
+    sl->event_pos[key.handle]     = pos;
+}
+
+
+static void event_sift_down(struct simlib *sl, int pos)
+{
+
+/* Move the key at heap slot pos down until no child is smaller. */
+
+    struct event_key key;
+    int    child, last, best, size;
+
+    size = sl->list_size[LIST_EVENT];
+    key  = sl->event_heap[pos];
+    for (;;) {
+        child = pos * HEAP_ARITY + 1;
+        if (child >= size) break;
+        last = child + HEAP_ARITY;
+        if (last > size) last = size;
+        for (best = child++; child < last; ++child)
+            if (event_key_less(&sl->event_heap[child], &sl->event_heap[best]))
+                best = child;
+        if (!event_key_less(&sl->event_heap[best], &key)) break;
+        sl->event_heap[pos]                      = sl->event_heap[best];
+        sl->event_pos[sl->event_heap[pos].handle]    = pos;
+        pos                                  = best;
+    }
+    sl->event_heap[pos]           = key;
+    sl->event_pos[key.handle]     = pos;
+}
+
+
+static int event_before(struct simlib *sl, int handle1, int handle2)
+{
+
+/* Return 1 if the event with handle1 occurs before the one with handle2. */
+
+    if(sl->event_rec[handle1].time != sl->event_rec[handle2].time)
+        return sl->event_rec[handle1].time < sl->event_rec[handle2].time;
+    return sl->event_seq[handle1] < sl->event_seq[handle2];
+}
+
+
+static long cal_day_of(struct simlib *sl, double time)
+{
+
+/* Return the calendar day (bucket-width interval) that contains time. */
+
+    return (long) floor(time / sl->cal_width);
+}
+
+
+static void cal_link(struct simlib *sl, int handle)
+{
+
+/* Insert handle into its calendar bucket, keeping the bucket sorted. */
+
+    int bucket, row, behind;
+
+    bucket = (int) (cal_day_of(sl, sl->event_rec[handle].time) % sl->cal_nbuckets);
+    behind = -1;
+    row    = sl->cal_bucket[bucket];
+    while (row >= 0 && event_before(sl, row, handle)) {
+        behind = row;
+        row    = sl->cal_next[row];
+    }
+    sl->cal_prev[handle] = behind;
+    sl->cal_next[handle] = row;
+    if (behind >= 0)
+        sl->cal_next[behind] = handle;
+    else
+        sl->cal_bucket[bucket] = handle;
+    if (row >= 0)
+        sl->cal_prev[row] = handle;
+}
 
-        if ((value > low) && (value < high)) {
-            list_remove(LAST, LIST_EVENT);
-            return 1;
+
+static void cal_unlink(struct simlib *sl, int handle)
+{
+
+/* Remove handle from its calendar bucket. */
+
+    int bucket;
+
+    if (sl->cal_prev[handle] >= 0)
+        sl->cal_next[sl->cal_prev[handle]] = sl->cal_next[handle];
+    else {
+        bucket             = (int) (cal_day_of(sl, sl->event_rec[handle].time) % sl->cal_nbuckets);
+        sl->cal_bucket[bucket] = sl->cal_next[handle];
+    }
+    if (sl->cal_next[handle] >= 0)
+        sl->cal_prev[sl->cal_next[handle]] = sl->cal_prev[handle];
+}
+
+
+static int cal_first(struct simlib *sl)
+{
+
+/* Return the handle of the earliest event in the calendar, advancing the
+   current day to the one that holds it.  No pending event is earlier than
+   the current day, so the head of the current day's bucket is the earliest
+   event if it falls on that day.  If a whole year of days is empty, fall
+   back to a direct search of the bucket heads. */
+
+    int  i, row, best;
+    long day;
+
+    day = sl->cal_day;
+    for (i = 0; i < sl->cal_nbuckets; ++i, ++day) {
+        row = sl->cal_bucket[day % sl->cal_nbuckets];
+        if (row >= 0 && cal_day_of(sl, sl->event_rec[row].time) == day) {
+            sl->cal_day = day;
+            return row;
+        }
+    }
+
+    best = -1;
+    for (i = 0; i < sl->cal_nbuckets; ++i) {
+        row = sl->cal_bucket[i];
+        if (row >= 0 && (best < 0 || event_before(sl, row, best))) best = row;
+    }
+    sl->cal_day = cal_day_of(sl, sl->event_rec[best].time);
+    return best;
+}
+
+
+static void cal_resize(struct simlib *sl, int nbuckets)
+{
+
+/* Rebuild the calendar with nbuckets buckets.  The new bucket width is three
+   times the average separation of the earliest CAL_SAMPLE events, ignoring
+   separations more than twice the average (Brown's heuristic). */
+
+    int    *pending, npending, nsample, i, j, row;
+    double  sample[CAL_SAMPLE], t;
+    double  average, sum;
+
+    /* Collect the pending events and the earliest event times. */
+
+    pending  = sl->cal_pending;
+    npending = 0;
+    nsample  = 0;
+    for (i = 0; i < sl->cal_nbuckets; ++i) {
+        for (row = sl->cal_bucket[i]; row >= 0; row = sl->cal_next[row]) {
+            pending[npending++] = row;
+            t = sl->event_rec[row].time;
+            if (nsample < CAL_SAMPLE || t < sample[nsample - 1]) {
+                if (nsample < CAL_SAMPLE) ++nsample;
+                for (j = nsample - 1; j > 0 && sample[j - 1] > t; --j)
+                    sample[j] = sample[j - 1];
+                sample[j] = t;
+            }
         }
+    }
 
-        else /* no match */
-            return 0;
+    /* Estimate the new bucket width, keeping the old one if the sample has
+       no spread. */
+
+    if (nsample > 1) {
+        average = (sample[nsample - 1] - sample[0]) / (nsample - 1);
+        sum     = 0.0;
+        j       = 0;
+        for (i = 1; i < nsample; ++i) {
+            if (sample[i] - sample[i - 1] <= 2.0 * average) {
+                sum += sample[i] - sample[i - 1];
+                ++j;
+            }
+        }
+        if (j > 0 && sum > 0.0) sl->cal_width = 3.0 * sum / j;
     }
 
-    /* Check to see if this is the head of the list.  If it is at the head, then
-       it MUST be a match. */
+    /* Refile every pending event into the new buckets. */
+
+    free(sl->cal_bucket);
+    sl->cal_nbuckets = nbuckets;
+    sl->cal_bucket   = (int *) malloc(sl->cal_nbuckets * sizeof(int));
+    for (i = 0; i < sl->cal_nbuckets; ++i)
+        sl->cal_bucket[i] = -1;
+
+    /* Start from the earliest pending event rather than the clock: an event
+       filed behind the clock (as when a rollback files events again) must
+       not be left on a day that cal_first has already passed. */
+
+    sl->cal_day = cal_day_of(sl, nsample > 0 ? sample[0] : sl->sim_time);
+    for (i = 0; i < npending; ++i)
+        cal_link(sl, pending[i]);
+}
 
-    if (row == head[LIST_EVENT]) {
-        list_remove(FIRST, LIST_EVENT);
-        return 1;
+
+static int event_file(struct simlib *sl, struct event *ev)
+{
+
+/* File a copy of *ev into the event list and return its handle.  Update
+   timest statistics for the event list. */
+
+    int handle, item, old_cap;
+
+    /* Get a free handle, growing the event storage if none is left. */
+
+    if (sl->event_num_free == 0) {
+        old_cap     = sl->event_cap;
+        sl->event_cap  *= 2;
+        sl->event_heap  = (struct event_key *) realloc(sl->event_heap,
+                                               sl->event_cap * sizeof(struct event_key));
+        sl->event_rec   = (struct event *) realloc(sl->event_rec,
+                                               sl->event_cap * sizeof(struct event));
+        sl->event_seq   = (unsigned long *) realloc(sl->event_seq,
+                                               sl->event_cap * sizeof(unsigned long));
+        sl->event_pos   = (int *)    realloc(sl->event_pos,   sl->event_cap * sizeof(int));
+        sl->event_free  = (int *)    realloc(sl->event_free,  sl->event_cap * sizeof(int));
+        sl->event_gen   = (unsigned int *) realloc(sl->event_gen,
+                                               sl->event_cap * sizeof(unsigned int));
+        sl->cal_next    = (int *)    realloc(sl->cal_next,    sl->event_cap * sizeof(int));
+        sl->cal_prev    = (int *)    realloc(sl->cal_prev,    sl->event_cap * sizeof(int));
+        sl->cal_pending = (int *)    realloc(sl->cal_pending, sl->event_cap * sizeof(int));
+        sl->pool_cap[POOL_EVENTS] = sl->event_cap;
+        for (item = sl->event_cap - 1; item >= old_cap; --item) {
+            sl->event_pos[item]                  = -1;
+            sl->event_gen[item]                  = 0;
+            sl->event_free[sl->event_num_free++] = item;
+        }
     }
+    handle = sl->event_free[--sl->event_num_free];
 
-    /* Else remove this event somewhere in the middle of the event list. */
+    /* Copy the event into its record. */
 
-    /* Update pointers. */
+    pool_note(sl, POOL_EVENTS, 1);
+    sl->list_size[LIST_EVENT]++;
+    sl->event_rec[handle] = *ev;
+    sl->event_seq[handle] = sl->event_num_seq++;
 
-    ahead        = (*row).sr;
-    behind       = (*row).pr;
-    (*behind).sr = ahead;
-    (*ahead).pr  = behind;
+    if (sl->event_list_kind == EVENTS_CALENDAR) {
 
-    /* Decrement the size of the event list. */
+        /* Link the event into its bucket, doubling the calendar when there
+           are more than two events per bucket.  An event filed before the
+           current day moves the calendar back so that timing still sees it
+           first. */
 
-    list_size[LIST_EVENT]--;
+        sl->event_pos[handle] = 0;
+        if (cal_day_of(sl, sl->event_rec[handle].time) < sl->cal_day)
+            sl->cal_day = cal_day_of(sl, sl->event_rec[handle].time);
+        cal_link(sl, handle);
+        if (sl->list_size[LIST_EVENT] > 2 * sl->cal_nbuckets)
+            cal_resize(sl, 2 * sl->cal_nbuckets);
+    }
 
-    /* Copy and free memory. */
+    else {
+
+        /* Add the key at the bottom of the heap and restore the heap order. */
 
-    free((char *)transfer);       /* Free the old transfer. */
-    transfer = (*row).value;      /* Transfer the data. */
-    free((char *)row);            /* Free the space vacated by row. */
+        item                    = sl->list_size[LIST_EVENT] - 1;
+        sl->event_heap[item].time   = sl->event_rec[handle].time;
+        sl->event_heap[item].seq    = sl->event_seq[handle];
+        sl->event_heap[item].handle = handle;
+        event_sift_up(sl, item);
+    }
 
     /* Update the area under the number-in-event-list curve. */
 
-    timest((float)list_size[LIST_EVENT], TIM_VAR + LIST_EVENT);
-    return 1;
+    timest(sl, (double)sl->list_size[LIST_EVENT], TIM_VAR + LIST_EVENT);
+    return handle;
+}
+
+
+static int event_first(struct simlib *sl)
+{
+
+/* Return the handle of the earliest pending event. */
+
+    if (sl->event_list_kind == EVENTS_CALENDAR) return cal_first(sl);
+    return sl->event_heap[0].handle;
+}
+
+
+static void event_take(struct simlib *sl, int handle, struct event *ev)
+{
+
+/* Remove the event with handle "handle" from the event list and copy it into
+   *ev.  Update timest statistics for the event list. */
+
+    int pos, last;
+
+    last = --sl->list_size[LIST_EVENT];
+
+    if (sl->event_list_kind == EVENTS_CALENDAR) {
+
+        /* Unlink the event, halving the calendar when there are fewer than
+           half an event per bucket. */
+
+        cal_unlink(sl, handle);
+        if (last < sl->cal_nbuckets / 2 - 2)
+            cal_resize(sl, sl->cal_nbuckets / 2);
+    }
+
+    else {
+
+        /* Fill the vacated slot with the last key and restore the heap
+           order. */
+
+        pos = sl->event_pos[handle];
+        if (pos != last) {
+            sl->event_heap[pos]                   = sl->event_heap[last];
+            sl->event_pos[sl->event_heap[pos].handle] = pos;
+            if (pos > 0 && event_key_less(&sl->event_heap[pos],
+                                          &sl->event_heap[(pos - 1) / HEAP_ARITY]))
+                event_sift_up(sl, pos);
+            else
+                event_sift_down(sl, pos);
+        }
+    }
+
+    /* Copy the event and free its handle, in a new generation. */
+
+    *ev               = sl->event_rec[handle];
+    sl->event_pos[handle] = -1;
+    sl->event_gen[handle] = (sl->event_gen[handle] + 1) & GEN_MASK;
+    sl->event_free[sl->event_num_free++] = handle;
+    pool_note(sl, POOL_EVENTS, -1);
+
+    /* Update the area under the number-in-event-list curve. */
+
+    timest(sl, (double)sl->list_size[LIST_EVENT], TIM_VAR + LIST_EVENT);
+}
+
+
+static void pool_note(struct simlib *sl, int pool, int change)
+{
+
+/* Record that change items of pool "pool" were taken (or returned). */
+
+    sl->pool_in_use[pool] += change;
+    if (sl->pool_in_use[pool] > sl->pool_high[pool]) sl->pool_high[pool] = sl->pool_in_use[pool];
+}
+
+
+static void slab_keep(struct simlib *sl, void *slab)
+{
+
+/* Remember a slab so that free_simlib can return it to the C allocator. */
+
+    if (sl->num_slabs == sl->slab_cap) {
+        sl->slab_cap = sl->slab_cap ? 2 * sl->slab_cap : 16;
+        sl->slabs    = (void **) realloc(sl->slabs, sl->slab_cap * sizeof(void *));
+    }
+    sl->slabs[sl->num_slabs++] = slab;
+}
+
+
+static struct master *row_alloc(struct simlib *sl)
+{
+
+/* Take a list row from the pool, carving a new slab if the pool is empty. */
+
+    struct master *row, *slab;
+    int    item;
+
+    if (sl->row_free == NULL) {
+        slab = (struct master *) malloc(POOL_SLAB * sizeof(struct master));
+        for (item = 0; item < POOL_SLAB; ++item) {
+            slab[item].sr = sl->row_free;
+            sl->row_free  = &slab[item];
+        }
+        slab_keep(sl, slab);
+        sl->pool_cap[POOL_ROWS] += POOL_SLAB;
+    }
+    row          = sl->row_free;
+    sl->row_free = (*row).sr;
+    pool_note(sl, POOL_ROWS, 1);
+    return row;
+}
+
+
+static void row_release(struct simlib *sl, struct master *row)
+{
+
+/* Return a list row to the pool. */
+
+    (*row).sr    = sl->row_free;
+    sl->row_free = row;
+    pool_note(sl, POOL_ROWS, -1);
+}
+
+
+static double *attr_alloc(struct simlib *sl)
+{
+
+/* Take an attribute vector from the pool, carving a new slab if the pool is
+   empty.  The vector is not cleared. */
+
+    double *slab;
+    int    item;
+
+    if (sl->attr_num_free == 0) {
+        slab = (double *) malloc(POOL_SLAB * sl->attr_size * sizeof(double));
+        slab_keep(sl, slab);
+        sl->pool_cap[POOL_ATTRS] += POOL_SLAB;
+        if (sl->attr_free_cap < sl->pool_cap[POOL_ATTRS]) {
+            sl->attr_free_cap = sl->pool_cap[POOL_ATTRS];
+            sl->attr_free     = (double **) realloc(sl->attr_free,
+                                                   sl->attr_free_cap * sizeof(double *));
+        }
+        for (item = POOL_SLAB - 1; item >= 0; --item)
+            sl->attr_free[sl->attr_num_free++] = slab + item * sl->attr_size;
+    }
+    pool_note(sl, POOL_ATTRS, 1);
+    return sl->attr_free[--sl->attr_num_free];
 }
 
 
-float sampst(float value, int variable)
+static void attr_release(struct simlib *sl, double *value)
+{
+
+/* Return an attribute vector to the pool. */
+
+    sl->attr_free[sl->attr_num_free++] = value;
+    pool_note(sl, POOL_ATTRS, -1);
+}
+
+
+double sampst(struct simlib *sl, double value, int variable)
 {
 
 /* Initialize, update, or report statistics on discrete-time processes:
@@ -443,51 +1236,51 @@ float sampst(float value, int variable)
            [3] = maximum of observations
            [4] = minimum of observations */
 
-    static int   ivar, num_observations[SVAR_SIZE];
-    static float max[SVAR_SIZE], min[SVAR_SIZE], sum[SVAR_SIZE];
+    int ivar;
 
     /* If the variable value is improper, stop the simulation. */
 
     if(!(variable >= -MAX_SVAR) && (variable <= MAX_SVAR)) {
         printf("\n%d is an improper value for a sampst variable at time %f\n",
-            variable, sim_time);
+            variable, sl->sim_time);
         exit(1);
     }
 
     /* Execute the desired option. */
 
     if(variable > 0) { /* Update. */
-        sum[variable] += value;
-        if(value > max[variable]) max[variable] = value;
-        if(value < min[variable]) min[variable] = value;
-        num_observations[variable]++;
+        sl->sampst_sum[variable] += value;
+        if(value > sl->sampst_max[variable]) sl->sampst_max[variable] = value;
+        if(value < sl->sampst_min[variable]) sl->sampst_min[variable] = value;
+        sl->sampst_count[variable]++;
         return 0.0;
     }
 
     if(variable < 0) { /* Report summary statistics in transfer. */
         ivar        = -variable;
-        transfer[2] = (float) num_observations[ivar];
-        transfer[3] = max[ivar];
-        transfer[4] = min[ivar];
-        if(num_observations[ivar] == 0)
-            transfer[1] = 0.0;
+        sl->transfer[2] = (double) sl->sampst_count[ivar];
+        sl->transfer[3] = sl->sampst_max[ivar];
+        sl->transfer[4] = sl->sampst_min[ivar];
+        if(sl->sampst_count[ivar] == 0)
+            sl->transfer[1] = 0.0;
         else
-            transfer[1] = sum[ivar] / transfer[2];
-        return transfer[1];
+            sl->transfer[1] = sl->sampst_sum[ivar] / sl->transfer[2];
+        return sl->transfer[1];
     }
 
     /* Initialize the accumulators. */
 
     for(ivar=1; ivar <= MAX_SVAR; ++ivar) {
-        sum[ivar]              = 0.0;
-        max[ivar]              = -INFINITY;
-        min[ivar]              =  INFINITY;
-        num_observations[ivar] = 0;
+        sl->sampst_sum[ivar]              = 0.0;
+        sl->sampst_max[ivar]              = -INFINITY;
+        sl->sampst_min[ivar]              =  INFINITY;
+        sl->sampst_count[ivar] = 0;
     }
+    return 0.0;
 }
 
 
-float timest(float value, int variable)
+double timest(struct simlib *sl, double value, int variable)
 {
 
 /* Initialize, update, or report statistics on continuous-time processes:
@@ -502,53 +1295,52 @@ float timest(float value, int variable)
    Note that variables TIM_VAR + 1 through TVAR_SIZE are used for automatic
    record keeping on the length of lists 1 through MAX_LIST. */
 
-    int          ivar;
-    static float area[TVAR_SIZE], max[TVAR_SIZE], min[TVAR_SIZE],
-                 preval[TVAR_SIZE], tlvc[TVAR_SIZE], treset;
+    int ivar;
 
     /* If the variable value is improper, stop the simulation. */
 
     if(!(variable >= -MAX_TVAR) && (variable <= MAX_TVAR)) {
         printf("\n%d is an improper value for a timest variable at time %f\n",
-            variable, sim_time);
+            variable, sl->sim_time);
         exit(1);
     }
 
     /* Execute the desired option. */
 
     if(variable > 0) { /* Update. */
-        area[variable] += (sim_time - tlvc[variable]) * preval[variable];
-        if(value > max[variable]) max[variable] = value;
-        if(value < min[variable]) min[variable] = value;
-        preval[variable] = value;
-        tlvc[variable]   = sim_time;
+        sl->timest_area[variable] += (sl->sim_time - sl->timest_tlvc[variable]) * sl->timest_preval[variable];
+        if(value > sl->timest_max[variable]) sl->timest_max[variable] = value;
+        if(value < sl->timest_min[variable]) sl->timest_min[variable] = value;
+        sl->timest_preval[variable] = value;
+        sl->timest_tlvc[variable]   = sl->sim_time;
         return 0.0;
     }
 
     if(variable < 0) { /* Report summary statistics in transfer. */
         ivar         = -variable;
-        area[ivar]   += (sim_time - tlvc[ivar]) * preval[ivar];
-        tlvc[ivar]   = sim_time;
-        transfer[1]  = area[ivar] / (sim_time - treset);
-        transfer[2]  = max[ivar];
-        transfer[3]  = min[ivar];
-        return transfer[1];
+        sl->timest_area[ivar]   += (sl->sim_time - sl->timest_tlvc[ivar]) * sl->timest_preval[ivar];
+        sl->timest_tlvc[ivar]   = sl->sim_time;
+        sl->transfer[1]  = sl->timest_area[ivar] / (sl->sim_time - sl->timest_treset);
+        sl->transfer[2]  = sl->timest_max[ivar];
+        sl->transfer[3]  = sl->timest_min[ivar];
+        return sl->transfer[1];
     }
 
     /* Initialize the accumulators. */
 
     for(ivar = 1; ivar <= MAX_TVAR; ++ivar) {
-        area[ivar]   = 0.0;
-        max[ivar]    = -INFINITY;
-        min[ivar]    =  INFINITY;
-        preval[ivar] = 0.0;
-        tlvc[ivar]   = sim_time;
+        sl->timest_area[ivar]   = 0.0;
+        sl->timest_max[ivar]    = -INFINITY;
+        sl->timest_min[ivar]    =  INFINITY;
+        sl->timest_preval[ivar] = 0.0;
+        sl->timest_tlvc[ivar]   = sl->sim_time;
     }
-    treset = sim_time;
+    sl->timest_treset = sl->sim_time;
+    return 0.0;
 }
 
 
-float filest(int list)
+double filest(struct simlib *sl, int list)
 {
 
 /* Report statistics on the length of list "list" in transfer:
@@ -557,11 +1349,34 @@ float filest(int list)
        [3] = minimum length list has attained
    This uses timest variable TIM_VAR + list. */
 
-    return timest(0.0, -(TIM_VAR + list));
+    return timest(sl, 0.0, -(TIM_VAR + list));
 }
 
 
-void out_sampst(FILE *unit, int lowvar, int highvar)
+double poolst(struct simlib *sl, int pool)
+{
+
+/* Report statistics on memory pool "pool" in transfer:
+       [1] = number of items currently in use
+       [2] = high-water mark of items in use
+       [3] = number of items allocated
+   where pool is POOL_ROWS (list rows), POOL_ATTRS (attribute vectors) or
+   POOL_EVENTS (event records). */
+
+    if(!((pool >= 1) && (pool < POOL_SIZE))) {
+        printf("\n%d is an improper value for a pool at time %f\n",
+            pool, sl->sim_time);
+        exit(1);
+    }
+
+    sl->transfer[1] = (double) sl->pool_in_use[pool];
+    sl->transfer[2] = (double) sl->pool_high[pool];
+    sl->transfer[3] = (double) sl->pool_cap[pool];
+    return sl->transfer[1];
+}
+
+
+void out_sampst(struct simlib *sl, FILE *unit, int lowvar, int highvar)
 {
 
 /* Write sampst statistics for variables lowvar through highvar on file
@@ -579,15 +1394,15 @@ void out_sampst(FILE *unit, int lowvar, int highvar)
     fprintf(unit, "_____________________________________");
     for(ivar = lowvar; ivar <= highvar; ++ivar) {
         fprintf(unit, "\n\n%5d", ivar);
-        sampst(0.00, -ivar);
-        for(iatrr = 1; iatrr <= 4; ++iatrr) pprint_out(unit, iatrr);
+        sampst(sl, 0.00, -ivar);
+        for(iatrr = 1; iatrr <= 4; ++iatrr) pprint_out(sl, unit, iatrr);
     }
     fprintf(unit, "\n___________________________________");
     fprintf(unit, "_____________________________________\n\n\n");
 }
 
 
-void out_timest(FILE *unit, int lowvar, int highvar)
+void out_timest(struct simlib *sl, FILE *unit, int lowvar, int highvar)
 {
 
 /* Write timest statistics for variables lowvar through highvar on file
@@ -604,15 +1419,15 @@ void out_timest(FILE *unit, int lowvar, int highvar)
     fprintf(unit, "\n________________________________________________________");
     for(ivar = lowvar; ivar <= highvar; ++ivar) {
         fprintf(unit, "\n\n%5d", ivar);
-        timest(0.00, -ivar);
-        for(iatrr = 1; iatrr <= 3; ++iatrr) pprint_out(unit, iatrr);
+        timest(sl, 0.00, -ivar);
+        for(iatrr = 1; iatrr <= 3; ++iatrr) pprint_out(sl, unit, iatrr);
     }
     fprintf(unit, "\n________________________________________________________");
     fprintf(unit, "\n\n\n");
 }
 
 
-void out_filest(FILE *unit, int lowlist, int highlist)
+void out_filest(struct simlib *sl, FILE *unit, int lowlist, int highlist)
 {
 
 /* Write timest list-length statistics for lists lowlist through highlist on
@@ -627,39 +1442,58 @@ void out_filest(FILE *unit, int lowlist, int highlist)
     fprintf(unit, "\n_______________________________________________________");
     for(list = lowlist; list <= highlist; ++list) {
         fprintf(unit, "\n\n%5d", list);
-        filest(list);
-        for(iatrr = 1; iatrr <= 3; ++iatrr) pprint_out(unit, iatrr);
+        filest(sl, list);
+        for(iatrr = 1; iatrr <= 3; ++iatrr) pprint_out(sl, unit, iatrr);
     }
     fprintf(unit, "\n_______________________________________________________");
     fprintf(unit, "\n\n\n");
 }
 
 
-void pprint_out(FILE *unit, int i) /* Write ith entry in transfer to file
+void out_poolst(struct simlib *sl, FILE *unit)
+{
+
+/* Write memory pool statistics on file "unit". */
+
+    int pool, iatrr;
+
+    fprintf(unit, "\n  Pool        In use      High-water mark      Allocated");
+    fprintf(unit, "\n_______________________________________________________");
+    for(pool = 1; pool < POOL_SIZE; ++pool) {
+        fprintf(unit, "\n\n%5d", pool);
+        poolst(sl, pool);
+        for(iatrr = 1; iatrr <= 3; ++iatrr) pprint_out(sl, unit, iatrr);
+    }
+    fprintf(unit, "\n_______________________________________________________");
+    fprintf(unit, "\n\n\n");
+}
+
+
+void pprint_out(struct simlib *sl, FILE *unit, int i) /* Write ith entry in transfer to file
                                       "unit". */
 {
-    if(transfer[i] == -1e30 || transfer[i] == 1e30)
+    if(sl->transfer[i] == -1e30 || sl->transfer[i] == 1e30)
         fprintf(unit," %#15.6G ", 0.00);
     else
-        fprintf(unit," %#15.6G ", transfer[i]);
+        fprintf(unit," %#15.6G ", sl->transfer[i]);
 }
 
 
-float expon(float mean, int stream) /* Exponential variate generation
+double expon(struct simlib *sl, double mean, int stream) /* Exponential variate generation
                                        function. */
 {
-    return -mean * log(lcgrand(stream));
+    return -mean * log(lcgrand(sl, stream));
 
 }
 
 
-int random_integer(float prob_distrib[], int stream) /* Discrete-variate
+int random_integer(struct simlib *sl, double prob_distrib[], int stream) /* Discrete-variate
                                                         generation function. */
 {
-    int   i;
-    float u;
+    int    i;
+    double u;
 
-    u = lcgrand(stream);
+    u = lcgrand(sl, stream);
 
     for (i = 1; u >= prob_distrib[i]; ++i)
         ;
@@ -667,23 +1501,23 @@ int random_integer(float prob_distrib[], int stream) /* Discrete-variate
 }
 
 
-float uniform(float a, float b, int stream) /* Uniform variate generation
+double uniform(struct simlib *sl, double a, double b, int stream) /* Uniform variate generation
                                                function. */
 {
-    return a + lcgrand(stream) * (b - a);
+    return a + lcgrand(sl, stream) * (b - a);
 }
 
 
-float erlang(int m, float mean, int stream)  /* Erlang variate generation
+double erlang(struct simlib *sl, int m, double mean, int stream)  /* Erlang variate generation
                                                 function. */
 {
-    int   i;
-    float mean_exponential, sum;
+    int    i;
+    double mean_exponential, sum;
 
     mean_exponential = mean / m;
     sum = 0.0;
     for (i = 1; i <= m; ++i)
-        sum += expon(mean_exponential, stream);
+        sum += expon(sl, mean_exponential, stream);
     return sum;
 }
 
@@ -702,13 +1536,13 @@ float erlang(int m, float mean, int stream)  /* Erlang variate generation
 
    1. To obtain the next U(0,1) random number from stream "stream,"
       execute
-          u = lcgrand(stream);
-      where lcgrand is a float function.  The float variable u will
+          u = lcgrand(sl, stream);
+      where lcgrand is a double function.  The double variable u will
       contain the next random number.
 
    2. To set the seed for stream "stream" to a desired value zset,
       execute
-          lcgrandst(zset, stream);
+          lcgrandst(sl, zset, stream);
       where lcgrandst is a void function and zset must be a long set to
       the desired seed, a number between 1 and 2147483646 (inclusive). 
       Default seeds for all 100 streams are given in the code.
@@ -716,7 +1550,7 @@ float erlang(int m, float mean, int stream)  /* Erlang variate generation
    3. To get the current (most recently used) integer in the sequence
       being generated for stream "stream" into the long variable zget,
       execute
-          zget = lcgrandgt(stream);
+          zget = lcgrandgt(sl, stream);
       where lcgrandgt is a long function. */
 
 /* Define the constants. */
@@ -725,35 +1559,13 @@ float erlang(int m, float mean, int stream)  /* Erlang variate generation
 #define MULT1       24112
 #define MULT2       26143
 
-/* Set the default seeds for all 100 streams. */
-
-static long zrng[] =
-{         1,
- 1973272912, 281629770,  20006270,1280689831,2096730329,1933576050,
-  913566091, 246780520,1363774876, 604901985,1511192140,1259851944,
-  824064364, 150493284, 242708531,  75253171,1964472944,1202299975,
-  233217322,1911216000, 726370533, 403498145, 993232223,1103205531,
-  762430696,1922803170,1385516923,  76271663, 413682397, 726466604,
-  336157058,1432650381,1120463904, 595778810, 877722890,1046574445,
-   68911991,2088367019, 748545416, 622401386,2122378830, 640690903,
- 1774806513,2132545692,2079249579,  78130110, 852776735,1187867272,
- 1351423507,1645973084,1997049139, 922510944,2045512870, 898585771,
-  243649545,1004818771, 773686062, 403188473, 372279877,1901633463,
-  498067494,2087759558, 493157915, 597104727,1530940798,1814496276,
-  536444882,1663153658, 855503735,  67784357,1432404475, 619691088,
-  119025595, 880802310, 176192644,1116780070, 277854671,1366580350,
- 1142483975,2026948561,1053920743, 786262391,1792203830,1494667770,
- 1923011392,1433700034,1244184613,1147297105, 539712780,1545929719,
-  190641742,1645390429, 264907697, 620389253,1502074852, 927711160,
-  364849192,2049576050, 638580085, 547070247 };
-
 /* Generate the next random number. */
 
-float lcgrand(int stream)
+double lcgrand(struct simlib *sl, int stream)
 {
     long zi, lowprd, hi31;
 
-    zi     = zrng[stream];
+    zi     = sl->zrng[stream];
     lowprd = (zi & 65535) * MULT1;
     hi31   = (zi >> 16) * MULT1 + (lowprd >> 16);
     zi     = ((lowprd & 65535) - MODLUS) +
@@ -764,20 +1576,20 @@ float lcgrand(int stream)
     zi     = ((lowprd & 65535) - MODLUS) +
              ((hi31 & 32767) << 16) + (hi31 >> 15);
     if (zi < 0) zi += MODLUS;
-    zrng[stream] = zi;
+    sl->zrng[stream] = zi;
     return (zi >> 7 | 1) / 16777216.0;
 }
 
 
-void lcgrandst (long zset, int stream) /* Set the current zrng for stream
+void lcgrandst(struct simlib *sl, long zset, int stream) /* Set the current zrng for stream
                                           "stream" to zset. */
 {
-    zrng[stream] = zset;
+    sl->zrng[stream] = zset;
 }
 
 
-long lcgrandgt (int stream) /* Return the current zrng for stream "stream". */
+long lcgrandgt(struct simlib *sl, int stream) /* Return the current zrng for stream "stream". */
 {
-    return zrng[stream];
+    return sl->zrng[stream];
 }
 
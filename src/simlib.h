@@ -7,35 +7,107 @@
 #include <math.h>
 #include "simlibdefs.h"
 
-/* Declare simlib global variables. */
+#ifndef SIMLIB_H
+#define SIMLIB_H
 
-extern int    *list_rank, *list_size, next_event_type, maxatr, maxlist;
-extern float  *transfer, sim_time, prob_distrib[26];
-extern struct master {
-    float  *value;
+/* A row of a list. */
+
+struct master {
+    double *value;
     struct master *pr;
     struct master *sr;
-} **head, **tail;
+};
+
+/* An event on the event list.  Events are stored by value, so their
+   attributes are typed rather than packed into transfer. */
+
+struct event {
+    double time;                  /* Event time. */
+    int    type;                  /* Event type. */
+    long   id[EVENT_IDS];         /* Integer attributes, e.g. entity numbers. */
+    double value[EVENT_VALUES];   /* Real attributes, e.g. times and amounts. */
+};
+
+/* A simlib context: the state of one simulation.  The fields in the first
+   group are the former simlib globals and may be read (and, where noted in
+   simlib.c, set) by the user; the rest are internal to simlib.c.  A context
+   is zeroed before its first init_simlib call, e.g. "struct simlib sl = {0};"
+   in C or value-initialization in C++. */
+
+struct simlib {
+    int    *list_rank, *list_size, next_event_type, maxatr, maxlist,
+           event_list_kind;
+    long long last_event_handle;
+    double *transfer, sim_time, prob_distrib[26];
+    struct master **head, **tail;
+
+    /* Event list. */
+
+    struct event_key *event_heap;
+    struct event     *event_rec;
+    unsigned long    *event_seq;
+    int              *event_pos, *event_free, *cal_next, *cal_prev;
+    unsigned int     *event_gen;
+    int               event_cap, event_num_free;
+    unsigned long     event_num_seq;
+    int              *cal_bucket, *cal_pending;
+    int               cal_nbuckets;
+    long              cal_day;
+    double            cal_width;
+
+    /* Memory pools. */
+
+    struct master    *row_free;
+    double          **attr_free;
+    int               attr_size, attr_num_free, attr_free_cap;
+    int               pool_in_use[POOL_SIZE], pool_high[POOL_SIZE],
+                      pool_cap[POOL_SIZE];
+    void            **slabs;
+    int               num_slabs, slab_cap;
+
+    /* Statistics. */
+
+    int    sampst_count[SVAR_SIZE];
+    double sampst_max[SVAR_SIZE], sampst_min[SVAR_SIZE], sampst_sum[SVAR_SIZE];
+    double timest_area[TVAR_SIZE], timest_max[TVAR_SIZE],
+           timest_min[TVAR_SIZE], timest_preval[TVAR_SIZE],
+           timest_tlvc[TVAR_SIZE], timest_treset;
+
+    /* Random-number streams. */
+
+    long   zrng[101];
+};
 
 /* Declare simlib functions. */
 
-extern void  init_simlib(void);
-extern void  list_file(int option, int list);
-extern void  list_remove(int option, int list);
-extern void  timing(void);
-extern void  event_schedule(float time_of_event, int type_of_event);
-extern int   event_cancel(int event_type);
-extern float sampst(float value, int varibl);
-extern float timest(float value, int varibl);
-extern float filest(int list);
-extern void  out_sampst(FILE *unit, int lowvar, int highvar);
-extern void  out_timest(FILE *unit, int lowvar, int highvar);
-extern void  out_filest(FILE *unit, int lowlist, int highlist);
-extern float expon(float mean, int stream);
-extern int   random_integer(float prob_distrib[], int stream);
-extern float uniform(float a, float b, int stream);
-extern float erlang(int m, float mean, int stream);
-extern float lcgrand(int stream);
-extern void  lcgrandst(long zset, int stream);
-extern long  lcgrandgt(int stream);
+extern void   init_simlib(struct simlib *sl);
+extern void   free_simlib(struct simlib *sl);
+extern void   list_file(struct simlib *sl, int option, int list);
+extern void   list_remove(struct simlib *sl, int option, int list);
+extern void   timing(struct simlib *sl);
+extern void   event_schedule(struct simlib *sl, double time_of_event, int type_of_event);
+extern int    event_cancel(struct simlib *sl, long long handle);
+extern long long event_post(struct simlib *sl, struct event *ev);
+extern void   event_next(struct simlib *sl, struct event *ev);
+extern double event_time(struct simlib *sl);
+extern void   event_visit(struct simlib *sl, void (*visit)(const struct event *ev, void *arg), void *arg);
+extern size_t simlib_save(struct simlib *sl, void *buf);
+extern size_t simlib_restore(struct simlib *sl, const void *buf, size_t len);
+extern double sampst(struct simlib *sl, double value, int varibl);
+extern double timest(struct simlib *sl, double value, int varibl);
+extern double filest(struct simlib *sl, int list);
+extern double poolst(struct simlib *sl, int pool);
+extern void   out_sampst(struct simlib *sl, FILE *unit, int lowvar, int highvar);
+extern void   out_timest(struct simlib *sl, FILE *unit, int lowvar, int highvar);
+extern void   out_filest(struct simlib *sl, FILE *unit, int lowlist, int highlist);
+extern void   out_poolst(struct simlib *sl, FILE *unit);
+extern void   pprint_out(struct simlib *sl, FILE *unit, int i);
+extern double expon(struct simlib *sl, double mean, int stream);
+extern int    random_integer(struct simlib *sl, double prob_distrib[], int stream);
+extern double uniform(struct simlib *sl, double a, double b, int stream);
+extern double erlang(struct simlib *sl, int m, double mean, int stream);
+extern double lcgrand(struct simlib *sl, int stream);
+extern void   lcgrandst(struct simlib *sl, long zset, int stream);
+extern long   lcgrandgt(struct simlib *sl, int stream);
 
+#endif
@@ -4,10 +4,12 @@
 
 #define MAX_LIST    25      /* Max number of lists. */
 #define MAX_ATTR    10      /* Max number of attributes. */
+#define EVENT_IDS    4      /* Integer attributes carried by an event. */
+#define EVENT_VALUES 2      /* Real attributes carried by an event. */
 #define MAX_SVAR    25      /* Max number of sampst variables. */
 #define TIM_VAR     25      /* Max number of timest variables. */
 #define MAX_TVAR    50      /* Max number of timest variables + lists. */
-#define EPSILON      0.001  /* Used in event_cancel. */
+#define EPSILON      0.001  /* Tolerance for comparing float attributes. */
 
 /* Define array sizes. */
 
@@ -23,6 +25,18 @@
 #define INCREASING   3      /* Insert in increasing order. */
 #define DECREASING   4      /* Insert in decreasing order. */
 
+/* Define implementations of the event list, selected by event_list_kind. */
+
+#define EVENTS_HEAP      1  /* Indexed d-ary heap. */
+#define EVENTS_CALENDAR  2  /* Calendar queue with automatic resizing. */
+
+/* Define memory pools reported by poolst. */
+
+#define POOL_ROWS    1      /* Rows of lists other than the event list. */
+#define POOL_ATTRS   2      /* Attribute vectors, including transfer. */
+#define POOL_EVENTS  3      /* Event records. */
+#define POOL_SIZE    4      /* Number of pools + 1. */
+
 /* Define some other values. */
 
 #define LIST_EVENT  25      /* Event list number. */